@@ -0,0 +1,814 @@
+// Standalone benchmarks for simulation hot paths. Build the AngryPandaBench target and
+// run it from a release build; results go to stdout as CSV, one row per case:
+//
+//   benchmark,n,ns_per_op_mean,ns_per_op_stddev,ns_per_op_min,repeats
+//
+// Usage: AngryPandaBench [--repeats N] [filter]   (filter matches benchmark names)
+#include "animation.hpp"
+#include "asset_cache.hpp"
+#include "broadphase.hpp"
+#include "enemy.hpp"
+#include "frame_arena.hpp"
+#include "job_system.hpp"
+#include "legacy_squirrel.hpp"
+#include "level_stream.hpp"
+#include "mixer.hpp"
+#include "player.hpp"
+#include "projectiles.hpp"
+#include "registry.hpp"
+#include "snapshot.hpp"
+#include "spatial_grid.hpp"
+#include "spsc_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr int kWorldHeight = 540;
+constexpr int kBranchSpacing = 400;  // keeps branch density constant as the level grows
+constexpr int kQueryCount = 1000000;
+constexpr float kTickDt = 1.0f / 120.0f;
+
+int g_repeats = 10;
+std::string g_filter;
+// Results are folded in here so the optimizer cannot drop the measured work.
+volatile long long g_sink = 0;
+
+bool Selected(const char* name) {
+    return g_filter.empty() || std::string(name).find(g_filter) != std::string::npos;
+}
+
+// Times fn, which performs ops operations per call, once to warm up and then g_repeats
+// times, and prints the spread of ns/op across repeats.
+template <typename Fn>
+void Measure(const char* name, long long n, long long ops, Fn&& fn) {
+    fn();
+
+    std::vector<double> samples;
+    samples.reserve(g_repeats);
+    for (int r = 0; r < g_repeats; ++r) {
+        const Clock::time_point start = Clock::now();
+        fn();
+        const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        samples.push_back(elapsed.count() / static_cast<double>(ops));
+    }
+
+    double mean = 0.0;
+    for (double s : samples) mean += s;
+    mean /= static_cast<double>(samples.size());
+    double variance = 0.0;
+    for (double s : samples) variance += (s - mean) * (s - mean);
+    variance /= static_cast<double>(std::max<std::size_t>(samples.size() - 1, 1));
+    const double min = *std::min_element(samples.begin(), samples.end());
+
+    std::printf("%s,%lld,%.2f,%.2f,%.2f,%d\n", name, n, mean, std::sqrt(variance), min, g_repeats);
+    std::fflush(stdout);
+}
+
+std::vector<SDL_Rect> MakeLevel(int platform_count, std::mt19937* rng) {
+    const int world_width = std::max(platform_count, 1) * kBranchSpacing;
+    std::uniform_int_distribution<int> x_dist(0, world_width - 200);
+    std::uniform_int_distribution<int> y_dist(100, kWorldHeight - 120);
+
+    std::vector<SDL_Rect> rects;
+    rects.reserve(platform_count + 1);
+    rects.push_back(SDL_Rect{0, kWorldHeight - 40, world_width, 40});  // ground
+    for (int i = 0; i < platform_count; ++i) {
+        rects.push_back(SDL_Rect{x_dist(*rng), y_dist(*rng), 200, 50});
+    }
+    return rects;
+}
+
+std::vector<SDL_Rect> MakeQueries(int world_width, int count, std::mt19937* rng) {
+    std::uniform_int_distribution<int> x_dist(0, world_width - 64);
+    std::uniform_int_distribution<int> y_dist(0, kWorldHeight - 80);
+    std::vector<SDL_Rect> queries;
+    queries.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        // Player body plus one tick of fall, the area CheckPlatformCollisions sweeps.
+        queries.push_back(SDL_Rect{x_dist(*rng), y_dist(*rng), 50, 72});
+    }
+    // A player moves through the level, so consecutive queries are spatially coherent.
+    std::sort(queries.begin(), queries.end(),
+              [](const SDL_Rect& a, const SDL_Rect& b) { return a.x < b.x; });
+    return queries;
+}
+
+// Four headless squirrel frames (no textures), so clips time exactly as they do in game.
+ClipId AddHeadlessSquirrelClip(AnimationLibrary* library) {
+    auto textures = std::make_shared<TextureSet>();
+    textures->frames.resize(4, SpriteFrame{nullptr, SDL_Rect{0, 0, 40, 40}});
+    textures->width = 40;
+    textures->height = 40;
+    return AddSquirrelClip(library, std::move(textures));
+}
+
+bool Overlaps(const SDL_Rect& a, const SDL_Rect& b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+void BenchPlatformGrid() {
+    std::mt19937 rng(1234);
+    for (int platform_count : {5, 50, 500, 5000, 50000, 100000}) {
+        const std::vector<SDL_Rect> rects = MakeLevel(platform_count, &rng);
+        const int world_width = rects[0].w;
+        const std::vector<SDL_Rect> queries = MakeQueries(world_width, kQueryCount, &rng);
+
+        StaticGrid grid;
+        grid.Build(rects);
+
+        if (Selected("grid_query")) {
+            Measure("grid_query", platform_count, kQueryCount, [&]() {
+                long long hits = 0;
+                for (const SDL_Rect& q : queries) {
+                    grid.Query(q, [&](int) { ++hits; });
+                }
+                g_sink = g_sink + hits;
+            });
+        }
+
+        // The old linear walk; sample fewer queries on large levels so the run stays short.
+        const int linear_queries = std::max(1000, kQueryCount / std::max(platform_count / 50, 1));
+        if (Selected("linear_query")) {
+            long long linear_hits = 0;
+            Measure("linear_query", platform_count, linear_queries, [&]() {
+                linear_hits = 0;
+                for (int i = 0; i < linear_queries; ++i) {
+                    for (const SDL_Rect& r : rects) {
+                        linear_hits += Overlaps(queries[i], r) ? 1 : 0;
+                    }
+                }
+                g_sink = g_sink + linear_hits;
+            });
+
+            long long grid_hits = 0;
+            for (int i = 0; i < linear_queries; ++i) {
+                grid.Query(queries[i], [&](int) { ++grid_hits; });
+            }
+            if (grid_hits != linear_hits) {
+                std::fprintf(stderr, "grid/linear mismatch at %d platforms: %lld vs %lld\n",
+                             platform_count, grid_hits, linear_hits);
+            }
+        }
+    }
+}
+
+// Input that cycles through walking, jumping and attacking like ScriptedInput in game.cpp.
+InputState ScriptedInput(int tick) {
+    InputState input{};
+    const bool right = (tick / 480) % 2 == 0;
+    input.move_right = right;
+    input.move_left = !right;
+    input.jump_pressed = tick % 90 == 0;
+    input.punch_pressed = tick % 50 == 25;
+    input.heel_kick_pressed = tick % 90 == 30;
+    return input;
+}
+
+void BenchPlayerUpdate() {
+    if (!Selected("player_update")) return;
+
+    constexpr int kTicks = 1000000;
+    std::vector<InputState> inputs;
+    inputs.reserve(960);
+    for (int tick = 0; tick < 960; ++tick) {
+        inputs.push_back(ScriptedInput(tick));
+    }
+
+    Measure("player_update", 1, kTicks, [&]() {
+        Registry registry;
+        Player player;
+        player.Attach(&registry);
+        player.SetGroundY(static_cast<float>(kWorldHeight - 40));
+        player.SetPosition(400.0f, 300.0f);
+        for (int tick = 0; tick < kTicks; ++tick) {
+            StorePreviousTransforms(&registry);
+            player.Update(kTickDt, inputs[tick % inputs.size()]);
+        }
+        g_sink = g_sink + static_cast<long long>(player.GetX());
+    });
+}
+
+void BenchPlayerCollisions() {
+    if (!Selected("player_platform_collisions")) return;
+
+    std::mt19937 rng(99);
+    for (int platform_count : {5, 500, 50000}) {
+        const std::vector<SDL_Rect> rects = MakeLevel(platform_count, &rng);
+        StaticGrid grid;
+        grid.Build(rects);
+
+        constexpr int kChecks = 200000;
+        constexpr float kFallPerCheck = 8.0f;
+        std::uniform_real_distribution<float> x_dist(0.0f, static_cast<float>(rects[0].w - 64));
+        std::uniform_real_distribution<float> y_dist(0.0f, static_cast<float>(kWorldHeight - 80));
+        std::vector<std::pair<float, float>> positions;
+        positions.reserve(kChecks);
+        for (int i = 0; i < kChecks; ++i) {
+            positions.emplace_back(x_dist(rng), y_dist(rng));
+        }
+        std::sort(positions.begin(), positions.end());
+
+        Measure("player_platform_collisions", platform_count, kChecks, [&]() {
+            Registry registry;
+            Player player;
+            player.Attach(&registry);
+            player.SetGroundY(static_cast<float>(kWorldHeight * 4));
+            float landed = 0.0f;
+            Transform& transform = registry.transforms.Get(player.GetEntity());
+            for (const auto& [x, y] : positions) {
+                // A fast fall, so every check sweeps a tick's worth of motion.
+                player.SetPosition(x, y);
+                transform.y += kFallPerCheck;
+                player.CheckPlatformCollisions(grid);
+                landed += player.GetY();
+            }
+            g_sink = g_sink + static_cast<long long>(landed);
+        });
+    }
+}
+
+// Squirrels spread along a long level, placed the same way for both layouts.
+SDL_FPoint SquirrelPosition(int index) {
+    return SDL_FPoint{static_cast<float>(index * 120), static_cast<float>(100 + (index % 4) * 100)};
+}
+
+// One tick's squirrel work as Game::Update does it: AI timers and shots, then the player's
+// attack, which is only live for a punch-length window every 50 ticks.
+void BenchSquirrelUpdate() {
+    if (!Selected("squirrel_update")) return;
+
+    auto acorns = std::make_unique<AcornPool>();
+    const SDL_Rect attack{600, 330, 44, 28};
+    const SDL_Rect no_attack{0, 0, 0, 0};
+    for (int squirrel_count : {16, 1000, 10000, 50000}) {
+        const SDL_Rect player_rect{squirrel_count * 60, 400, 50, 70};
+        const int ticks = std::max(200, 2000000 / squirrel_count);
+        const long long ops = static_cast<long long>(ticks) * squirrel_count;
+
+        if (Selected("squirrel_update_legacy")) {
+            std::vector<LegacySquirrel> squirrels(squirrel_count);
+            for (int i = 0; i < squirrel_count; ++i) {
+                const SDL_FPoint p = SquirrelPosition(i);
+                squirrels[i].SetPosition(p.x, p.y);
+            }
+
+            Measure("squirrel_update_legacy", squirrel_count, ops, [&]() {
+                acorns->Clear();
+                for (int tick = 0; tick < ticks; ++tick) {
+                    const SDL_Rect& attack_rect = tick % 50 < 22 ? attack : no_attack;
+                    for (LegacySquirrel& squirrel : squirrels) {
+                        squirrel.Update(kTickDt, player_rect, acorns.get());
+                        squirrel.TryTakeHit(attack_rect);
+                    }
+                    // Keep the pool from saturating, which would turn every shot into a no-op.
+                    if (acorns->Count() > AcornPool::kCapacity / 2) {
+                        acorns->Clear();
+                    }
+                }
+                g_sink = g_sink + acorns->Count();
+            });
+        }
+
+        if (Selected("squirrel_update_ecs")) {
+            AnimationLibrary animations;
+            const ClipId clip = AddHeadlessSquirrelClip(&animations);
+            Registry registry;
+            for (int i = 0; i < squirrel_count; ++i) {
+                const SDL_FPoint p = SquirrelPosition(i);
+                SpawnSquirrel(&registry, p.x, p.y, clip);
+            }
+
+            Measure("squirrel_update_ecs", squirrel_count, ops, [&]() {
+                acorns->Clear();
+                for (int tick = 0; tick < ticks; ++tick) {
+                    const SDL_Rect& attack_rect = tick % 50 < 22 ? attack : no_attack;
+                    UpdateSquirrels(&registry, kTickDt, player_rect, acorns.get());
+                    HitSquirrels(&registry, attack_rect);
+                    AdvanceAnimations(&registry, animations, kTickDt);
+                    if (acorns->Count() > AcornPool::kCapacity / 2) {
+                        acorns->Clear();
+                    }
+                }
+                g_sink = g_sink + acorns->Count();
+            });
+        }
+    }
+}
+
+// A whole tick of enemy work (AI, shots, acorn flight, hits on the player) serially and on the
+// job system. Both runs start from the same state and must end bit-identical.
+void BenchEnemyTickJobs() {
+    if (!Selected("enemy_tick")) return;
+
+    JobSystem jobs;
+    jobs.Init(JobSystem::DefaultWorkerThreads());
+    const SDL_Rect attack{600, 330, 44, 28};
+    const SDL_Rect no_attack{0, 0, 0, 0};
+
+    for (int squirrel_count : {1000, 10000, 100000}) {
+        const SDL_Rect player_rect{squirrel_count * 60, 400, 50, 70};
+        const int ticks = std::max(100, 2000000 / squirrel_count);
+
+        struct World {
+            Registry registry;
+            std::unique_ptr<AcornPool> acorns = std::make_unique<AcornPool>();
+        };
+        auto make_world = [&]() {
+            auto world = std::make_unique<World>();
+            for (int i = 0; i < squirrel_count; ++i) {
+                const SDL_FPoint p = SquirrelPosition(i);
+                SpawnSquirrel(&world->registry, p.x, p.y);
+            }
+            return world;
+        };
+        auto run = [&](World* world, JobSystem* job_system) {
+            for (int tick = 0; tick < ticks; ++tick) {
+                const SDL_Rect& attack_rect = tick % 50 < 22 ? attack : no_attack;
+                UpdateSquirrels(&world->registry, kTickDt, player_rect, world->acorns.get(), job_system);
+                HitSquirrels(&world->registry, attack_rect, job_system);
+                world->acorns->Update(kTickDt, job_system);
+                float knockback = 0.0f;
+                world->acorns->CheckHitPlayer(player_rect, SDL_FPoint{0.0f, 0.0f}, &knockback, job_system);
+            }
+        };
+        auto state_hash = [](const World& world) {
+            StateHasher hasher;
+            HashState(world.registry, &hasher);
+            hasher.Add(world.acorns->StateHash());
+            return hasher.Value();
+        };
+
+        std::unique_ptr<World> serial = make_world();
+        std::unique_ptr<World> parallel = make_world();
+        const long long ops = static_cast<long long>(ticks) * squirrel_count;
+        Measure("enemy_tick_serial", squirrel_count, ops, [&]() { run(serial.get(), nullptr); });
+        Measure("enemy_tick_jobs", squirrel_count, ops, [&]() { run(parallel.get(), &jobs); });
+
+        // Both worlds ran the same number of ticks (warm-up plus repeats).
+        if (state_hash(*serial) != state_hash(*parallel)) {
+            std::fprintf(stderr, "enemy_tick: job system diverged from serial at %d squirrels\n", squirrel_count);
+        }
+    }
+}
+
+// A whole tick of enemy work (AI, shots, acorn flight, hits on the player) with every squirrel
+// ticking every tick against the level-of-detail tiers, as the view pans along the level.
+// Offscreen squirrels no longer keep the acorn pool full. The tiered run also checks serial
+// against the job system.
+void BenchSquirrelLod() {
+    if (!Selected("squirrel_lod")) return;
+
+    JobSystem jobs;
+    jobs.Init(JobSystem::DefaultWorkerThreads());
+    constexpr float kViewWidth = 960.0f;
+    constexpr float kPanPerTick = 4.0f;
+
+    for (int squirrel_count : {1000, 10000, 100000}) {
+        const int ticks = std::max(100, 2000000 / squirrel_count);
+        const float level_width = SquirrelPosition(squirrel_count).x;
+
+        struct World {
+            Registry registry;
+            std::unique_ptr<AcornPool> acorns = std::make_unique<AcornPool>();
+            SquirrelLod lod;
+            int tick = 0;
+        };
+        auto make_world = [&]() {
+            auto world = std::make_unique<World>();
+            for (int i = 0; i < squirrel_count; ++i) {
+                const SDL_FPoint p = SquirrelPosition(i);
+                SpawnSquirrel(&world->registry, p.x, p.y);
+            }
+            IndexSquirrels(world->registry, &world->lod);
+            return world;
+        };
+        auto run = [&](World* world, JobSystem* job_system, bool use_lod) {
+            for (int tick = 0; tick < ticks; ++tick, ++world->tick) {
+                const float view_left = std::fmod(level_width * 0.5f + world->tick * kPanPerTick, level_width);
+                const SDL_Rect player_rect{static_cast<int>(view_left) + 480, 400, 50, 70};
+                world->lod.view_left = view_left;
+                world->lod.view_width = kViewWidth;
+                UpdateSquirrels(&world->registry, kTickDt, player_rect, world->acorns.get(), job_system,
+                                use_lod ? &world->lod : nullptr);
+                world->acorns->Update(kTickDt, job_system);
+                float knockback = 0.0f;
+                world->acorns->CheckHitPlayer(player_rect, SDL_FPoint{kPanPerTick, 0.0f}, &knockback, job_system);
+            }
+        };
+        auto state_hash = [](const World& world) {
+            StateHasher hasher;
+            HashState(world.registry, &hasher);
+            hasher.Add(world.acorns->StateHash());
+            return hasher.Value();
+        };
+
+        std::unique_ptr<World> every_tick = make_world();
+        std::unique_ptr<World> serial = make_world();
+        std::unique_ptr<World> parallel = make_world();
+        const long long ops = static_cast<long long>(ticks) * squirrel_count;
+        Measure("squirrel_lod_off", squirrel_count, ops, [&]() { run(every_tick.get(), nullptr, false); });
+        Measure("squirrel_lod_serial", squirrel_count, ops, [&]() { run(serial.get(), nullptr, true); });
+        Measure("squirrel_lod_jobs", squirrel_count, ops, [&]() { run(parallel.get(), &jobs, true); });
+
+        if (state_hash(*serial) != state_hash(*parallel)) {
+            std::fprintf(stderr, "squirrel_lod: job system diverged from serial at %d squirrels\n", squirrel_count);
+        }
+        const SquirrelLodStats& total = serial->lod.total;
+        const double lod_ticks = static_cast<double>(serial->lod.ticks);
+        std::fprintf(stderr, "squirrel_lod: %d squirrels, per tick %.1f near, %.1f far ticked, %.1f far waiting, "
+                     "%.1f dormant\n", squirrel_count, total.near_ticked / lod_ticks, total.far_ticked / lod_ticks,
+                     total.far_waiting / lod_ticks, total.dormant / lod_ticks);
+    }
+}
+
+void BenchAcornHitPlayer() {
+    if (!Selected("acorn_check_hit_player")) return;
+
+    auto acorns = std::make_unique<AcornPool>();
+    std::mt19937 rng(7);
+    for (int acorn_count : {16, 256, 4096}) {
+        // Acorns spread across the level but never on the player, so none are consumed.
+        acorns->Clear();
+        std::uniform_real_distribution<float> x_dist(0.0f, 5000.0f);
+        std::uniform_real_distribution<float> y_dist(0.0f, 300.0f);
+        for (int i = 0; i < acorn_count; ++i) {
+            acorns->Spawn(x_dist(rng), y_dist(rng), 0.0f, 0.0f);
+        }
+        const SDL_Rect player_rect{2500, 420, 50, 70};
+        const SDL_FPoint player_motion{2.0f, 4.0f};  // walking and falling, so paths are swept
+
+        constexpr int kChecks = 20000;
+        Measure("acorn_check_hit_player", acorn_count, kChecks, [&]() {
+            int hits = 0;
+            float knockback = 0.0f;
+            for (int i = 0; i < kChecks; ++i) {
+                hits += acorns->CheckHitPlayer(player_rect, player_motion, &knockback) ? 1 : 0;
+            }
+            g_sink = g_sink + hits;
+        });
+    }
+}
+
+// Candidate pairs between acorns and squirrel bodies with both counts growing, so targets
+// grow with the shooters: the incremental sort-and-sweep against testing every box against
+// every other. Acorns that fall out are refired from a squirrel, as in the game.
+void BenchBroadphase() {
+    if (!Selected("broadphase")) return;
+
+    for (int count : {256, 1024, 4096}) {
+        Registry registry;
+        for (int i = 0; i < count; ++i) {
+            const SDL_FPoint p = SquirrelPosition(i);
+            SpawnSquirrel(&registry, p.x, p.y);
+        }
+        auto acorns = std::make_unique<AcornPool>();
+        acorns->SetBounds(-1000.0f, SquirrelPosition(count).x + 1000.0f);
+        int next_shooter = 0;
+        auto refill = [&]() {
+            while (acorns->Count() < count) {
+                const SDL_FPoint p = SquirrelPosition(next_shooter);
+                const float vx = next_shooter % 2 ? 280.0f : -280.0f;
+                acorns->Spawn(p.x + 22.0f, p.y - 24.0f, vx, -120.0f);
+                next_shooter = (next_shooter + 7) % count;
+            }
+        };
+
+        Broadphase broadphase;
+        broadphase.Collide(BroadphaseLayer::kProjectile, BroadphaseLayer::kEnemyBody);
+        auto tick = [&]() {
+            acorns->Update(kTickDt);
+            refill();
+            broadphase.Begin();
+            AddSquirrelColliders(registry, &broadphase);
+            acorns->AddColliders(&broadphase);
+            broadphase.FindPairs();
+        };
+        refill();
+
+        constexpr int kTicks = 200;
+        Measure("broadphase_sweep", count, kTicks, [&]() {
+            for (int i = 0; i < kTicks; ++i) {
+                tick();
+            }
+            g_sink = g_sink + static_cast<long long>(broadphase.Pairs().size());
+        });
+
+        // The brute-force pass is quadratic; a few ticks are enough to time it.
+        const int brute_ticks = std::max(2, 2000000 / (count * count / 64));
+        int mismatches = 0;
+        Measure("broadphase_brute_force", count, brute_ticks, [&]() {
+            for (int i = 0; i < brute_ticks; ++i) {
+                mismatches += broadphase.MatchesBruteForce() ? 0 : 1;
+            }
+        });
+        if (mismatches > 0) {
+            std::fprintf(stderr, "broadphase: sweep and brute force disagree at %d boxes\n", broadphase.ProxyCount());
+        }
+    }
+}
+
+// Cost of asking for a sound effect from gameplay code: the old name lookup (two std::map
+// finds with string compares) against pushing a handle onto the audio command queue.
+void BenchSoundRequests() {
+    if (!Selected("sfx_")) return;
+
+    struct Command {
+        std::uint16_t sound;
+        int volume;
+    };
+    const std::vector<std::string> names{"walk", "hurt", "death", "punch", "heel"};
+    constexpr int kRequests = 1000000;
+    constexpr int kBurst = 64;  // a busy frame's worth of requests between drains
+
+    std::map<std::string, int> by_name;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        by_name[names[i]] = static_cast<int>(i);
+    }
+    Measure("sfx_map_lookup_legacy", static_cast<long long>(names.size()), kRequests, [&]() {
+        long long sum = 0;
+        for (int i = 0; i < kRequests; ++i) {
+            const std::string& name = names[i % names.size()];
+            if (by_name.count(name)) {
+                sum += by_name[name];
+            }
+        }
+        g_sink = g_sink + sum;
+    });
+
+    auto queue = std::make_unique<SpscQueue<Command, 256>>();
+    Measure("sfx_queue_push_pop", kBurst, kRequests, [&]() {
+        long long sum = 0;
+        Command command{};
+        for (int i = 0; i < kRequests; i += kBurst) {
+            for (int j = 0; j < kBurst; ++j) {
+                queue->TryPush(Command{static_cast<std::uint16_t>(j % 5), -1});
+            }
+            while (queue->TryPop(&command)) {
+                sum += command.sound;
+            }
+        }
+        g_sink = g_sink + sum;
+    });
+
+    // Producer and consumer on different threads, as in AudioManager; each side yields
+    // when the ring is full or empty, so this is the throughput bound rather than typical latency.
+    Measure("sfx_queue_cross_thread", 256, kRequests, [&]() {
+        std::thread consumer([&]() {
+            long long sum = 0;
+            Command command{};
+            for (int received = 0; received < kRequests;) {
+                if (queue->TryPop(&command)) {
+                    sum += command.sound;
+                    ++received;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            g_sink = g_sink + sum;
+        });
+        for (int i = 0; i < kRequests;) {
+            if (queue->TryPush(Command{static_cast<std::uint16_t>(i % 5), -1})) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        consumer.join();
+    });
+}
+
+// Cost of the audio callback per voice: one 2048-frame device buffer of stereo int16,
+// float accumulation with per-voice gain and pan, and the saturating conversion back.
+void BenchMixer() {
+    if (!Selected("mixer_")) return;
+
+    constexpr int kBufferFrames = 2048;
+    constexpr int kBuffers = 64;
+    SoundBuffer noise;
+    noise.samples.resize(static_cast<std::size_t>(kBufferFrames) * kBuffers * 2);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> sample_dist(-20000, 20000);
+    for (std::int16_t& sample : noise.samples) {
+        sample = static_cast<std::int16_t>(sample_dist(rng));
+    }
+    std::vector<std::int16_t> out(kBufferFrames * 2);
+
+    for (int voices : {1, 8, Mixer::kMaxVoices + 1}) {
+        auto mixer = std::make_unique<Mixer>();
+        auto music = std::make_unique<MusicRing>();
+        mixer->SetMusicSource(music.get());
+        Measure("mixer_voice_buffer", voices, static_cast<long long>(kBuffers) * voices, [&]() {
+            // One voice is the music stream; the rest are one-shots long enough to last the run.
+            for (int v = 1; v < voices; ++v) {
+                mixer->Play(noise, 0.5f, (v % 9) / 4.0f - 1.0f);
+            }
+            for (int b = 0; b < kBuffers; ++b) {
+                music->PushSome(noise.samples.data() + b * kBufferFrames * 2, kBufferFrames * 2);
+                mixer->Mix(out.data(), kBufferFrames);
+            }
+            g_sink = g_sink + out[kBufferFrames] + mixer->ActiveVoices();
+        });
+    }
+}
+
+void BenchCollectFrames() {
+    if (!Selected("collect_frames_by_prefix")) return;
+
+    const fs::path dir = fs::temp_directory_path() / "angrypanda_bench_frames";
+    for (int frame_count : {8, 64, 512}) {
+        // Frames plus as many unrelated files, like an assets directory that was flattened.
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        for (int i = frame_count - 1; i >= 0; --i) {
+            std::ofstream(dir / ("walk" + std::to_string(i) + ".bmp")).put('\0');
+            std::ofstream(dir / ("other" + std::to_string(i) + ".bmp")).put('\0');
+        }
+
+        const int calls = std::max(20, 20000 / frame_count);
+        Measure("collect_frames_by_prefix", frame_count, calls, [&]() {
+            std::size_t found = 0;
+            for (int i = 0; i < calls; ++i) {
+                found += CollectFramesByPrefix(dir, "walk").size();
+            }
+            g_sink = g_sink + static_cast<long long>(found);
+        });
+    }
+    fs::remove_all(dir);
+}
+
+// Saving and restoring the entity and acorn state, as a benchmark loop resetting to a saved
+// moment would. After the restores the state must hash the same as when it was saved.
+void BenchSnapshot() {
+    if (!Selected("snapshot")) return;
+
+    for (int squirrel_count : {100, 1000, 10000}) {
+        Registry registry;
+        auto acorns = std::make_unique<AcornPool>();
+        for (int i = 0; i < squirrel_count; ++i) {
+            const SDL_FPoint p = SquirrelPosition(i);
+            SpawnSquirrel(&registry, p.x, p.y);
+        }
+        const SDL_Rect player_rect{squirrel_count * 60, 400, 50, 70};
+        for (int tick = 0; tick < 240; ++tick) {
+            UpdateSquirrels(&registry, kTickDt, player_rect, acorns.get());
+            acorns->Update(kTickDt);
+        }
+        auto state_hash = [&]() {
+            StateHasher hasher;
+            HashState(registry, &hasher);
+            hasher.Add(acorns->StateHash());
+            return hasher.Value();
+        };
+        const std::uint64_t saved_hash = state_hash();
+
+        constexpr int kCalls = 200;
+        std::vector<std::uint8_t> bytes;
+        Measure("snapshot_save", squirrel_count, kCalls, [&]() {
+            for (int i = 0; i < kCalls; ++i) {
+                SnapshotWriter out(&bytes);
+                registry.Save(&out);
+                acorns->Save(&out);
+            }
+            g_sink = g_sink + static_cast<long long>(bytes.size());
+        });
+        bool restored = true;
+        Measure("snapshot_restore", squirrel_count, kCalls, [&]() {
+            for (int i = 0; i < kCalls; ++i) {
+                SnapshotReader in(bytes.data(), bytes.size());
+                restored = restored && registry.Restore(&in) && acorns->Restore(&in) && in.Done();
+            }
+        });
+
+        if (!restored || state_hash() != saved_hash) {
+            std::fprintf(stderr, "snapshot: restored state differs from the saved one at %d squirrels\n",
+                         squirrel_count);
+        }
+    }
+}
+
+// A frame's worth of scratch lists (visible indices, overlapping rects) built in a fresh
+// std::vector each frame against the frame arena, which only bumps a pointer.
+void BenchFrameScratch() {
+    if (!Selected("frame_scratch")) return;
+
+    constexpr int kFrames = 2000;
+    constexpr int kListsPerFrame = 8;
+    for (int items : {16, 256, 4096}) {
+        Measure("frame_scratch_vector", items, kFrames, [&]() {
+            long long total = 0;
+            for (int frame = 0; frame < kFrames; ++frame) {
+                for (int list = 0; list < kListsPerFrame; ++list) {
+                    std::vector<SDL_Rect> rects;
+                    for (int i = 0; i < items; ++i) {
+                        rects.push_back(SDL_Rect{i, list, 1, 1});
+                    }
+                    total += rects.back().x;
+                }
+            }
+            g_sink = g_sink + total;
+        });
+
+        FrameArena arena;
+        arena.Init(kListsPerFrame * items * sizeof(SDL_Rect) + kListsPerFrame * alignof(SDL_Rect));
+        Measure("frame_scratch_arena", items, kFrames, [&]() {
+            long long total = 0;
+            for (int frame = 0; frame < kFrames; ++frame) {
+                arena.Reset();
+                for (int list = 0; list < kListsPerFrame; ++list) {
+                    ArenaArray<SDL_Rect> rects = arena.MakeArray<SDL_Rect>(items);
+                    for (int i = 0; i < items; ++i) {
+                        rects.push_back(SDL_Rect{i, list, 1, 1});
+                    }
+                    total += rects[rects.size() - 1].x;
+                }
+            }
+            g_sink = g_sink + total;
+        });
+    }
+}
+
+// Walks the view through the first 48 chunks of levels of growing length at running speed;
+// per-tick cost must not depend on the length. The walk runs far faster than real time, so
+// the loader falls behind and part of the cost is Update waiting for it.
+void BenchLevelStream() {
+    if (!Selected("level_stream_walk")) return;
+
+    const fs::path dir = fs::temp_directory_path() / "angrypanda_bench_level";
+    for (int chunk_count : {64, 256, 1024}) {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        for (int i = 0; i < chunk_count; ++i) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "chunk_%03d.txt", i);
+            std::ofstream file(dir / name);
+            file << "ground 0 " << LevelStreamer::kChunkWidth << "\n";
+            for (int x = 0; x < LevelStreamer::kChunkWidth; x += 128) {
+                file << "branch " << x << " " << 150 + (x % 300) << " 100 40\n"
+                     << "squirrel " << x + 20 << " " << 150 + (x % 300) << "\n"
+                     << "bush " << x << "\n";
+            }
+        }
+
+        LevelStreamer level;
+        level.Open({dir}, kWorldHeight);
+        std::vector<const LevelChunk*> activated;
+        std::vector<int> deactivated;
+        const float step = 300.0f * kTickDt;
+        const int ticks = static_cast<int>(48 * LevelStreamer::kChunkWidth / step);
+        Measure("level_stream_walk", chunk_count, ticks, [&]() {
+            std::size_t changes = 0;
+            for (int tick = 0; tick < ticks; ++tick) {
+                level.Update(tick * step, 960, &activated, &deactivated);
+                changes += activated.size() + deactivated.size();
+            }
+            g_sink = g_sink + static_cast<long long>(changes);
+        });
+    }
+    fs::remove_all(dir);
+}
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--repeats" && i + 1 < argc) {
+            g_repeats = std::max(2, std::atoi(argv[++i]));
+        } else {
+            g_filter = arg;
+        }
+    }
+
+    std::printf("benchmark,n,ns_per_op_mean,ns_per_op_stddev,ns_per_op_min,repeats\n");
+    BenchPlatformGrid();
+    BenchPlayerUpdate();
+    BenchPlayerCollisions();
+    BenchSquirrelUpdate();
+    BenchEnemyTickJobs();
+    BenchSquirrelLod();
+    BenchAcornHitPlayer();
+    BenchBroadphase();
+    BenchSoundRequests();
+    BenchMixer();
+    BenchCollectFrames();
+    BenchLevelStream();
+    BenchFrameScratch();
+    BenchSnapshot();
+    return 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+// The squirrel as it was before the entity-component port: one object per squirrel holding
+// position, timers and its own texture handle. Kept only as the benchmark baseline.
+#include <SDL.h>
+#include <algorithm>
+#include <cmath>
+#include "projectiles.hpp"
+#include "texture_set.hpp"
+
+class LegacySquirrel {
+public:
+    void SetPosition(float x, float y) {
+        x_ = x;
+        y_ = y;
+    }
+
+    void SetTextures(TextureHandle squirrel_textures) { squirrel_textures_ = std::move(squirrel_textures); }
+
+    void Update(float dt, const SDL_Rect& player_rect, AcornPool* acorns) {
+        if (hurt_cooldown_ > 0.0f) {
+            hurt_cooldown_ = std::max(0.0f, hurt_cooldown_ - dt);
+        }
+
+        if (hits_remaining_ > 0) {
+            shot_timer_ -= dt;
+            if (shot_timer_ <= 0.0f) {
+                shot_timer_ = kShootCooldown;
+
+                const float start_x = x_ + (kSquirrelWidth * 0.5f);
+                const float start_y = y_ - (kSquirrelHeight * 0.65f);
+                const float target_x = static_cast<float>(player_rect.x + player_rect.w / 2);
+                const float target_y = static_cast<float>(player_rect.y + player_rect.h / 2);
+                float dx = target_x - start_x;
+                float dy = target_y - start_y;
+                const float length = std::max(std::sqrt(dx * dx + dy * dy), 1.0f);
+                dx /= length;
+                dy /= length;
+
+                acorns->Spawn(start_x, start_y, dx * kAcornSpeed, dy * kAcornSpeed - 30.0f);
+            }
+        }
+    }
+
+    bool TryTakeHit(const SDL_Rect& attack_rect) {
+        if (hits_remaining_ <= 0 || hurt_cooldown_ > 0.0f || attack_rect.w <= 0 || attack_rect.h <= 0) {
+            return false;
+        }
+
+        SDL_Rect enemy_rect = GetBodyRect();
+        if (!SDL_HasIntersection(&enemy_rect, &attack_rect)) {
+            return false;
+        }
+
+        --hits_remaining_;
+        hurt_cooldown_ = kHurtCooldown;
+        return true;
+    }
+
+private:
+    static constexpr int kSquirrelWidth = 44;
+    static constexpr int kSquirrelHeight = 36;
+    static constexpr float kShootCooldown = 1.6f;
+    static constexpr float kHurtCooldown = 0.3f;
+    static constexpr float kAcornSpeed = 280.0f;
+
+    SDL_Rect GetBodyRect() const {
+        return SDL_Rect{static_cast<int>(x_), static_cast<int>(y_) - kSquirrelHeight, kSquirrelWidth, kSquirrelHeight};
+    }
+
+    float x_ = 0.0f;
+    float y_ = 0.0f;
+    float shot_timer_ = 0.9f;
+    float hurt_cooldown_ = 0.0f;
+    int hits_remaining_ = 2;
+    TextureHandle squirrel_textures_{};
+};
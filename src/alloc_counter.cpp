@@ -0,0 +1,102 @@
+#include "alloc_counter.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace alloc_counter {
+namespace {
+thread_local std::uint64_t t_allocations = 0;
+}
+
+#ifdef ALLOC_CHECK
+bool Enabled() { return true; }
+#else
+bool Enabled() { return false; }
+#endif
+
+std::uint64_t ThreadAllocations() { return t_allocations; }
+
+#ifdef ALLOC_CHECK
+namespace {
+void* Allocate(std::size_t size) {
+    ++t_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* AllocateAligned(std::size_t size, std::size_t alignment) {
+    ++t_allocations;
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    size = (std::max<std::size_t>(size, 1) + alignment - 1) & ~(alignment - 1);
+#ifdef _WIN32
+    void* p = _aligned_malloc(size, alignment);
+#else
+    void* p = std::aligned_alloc(alignment, size);
+#endif
+    if (p) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void FreeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+}
+#endif
+
+}
+
+#ifdef ALLOC_CHECK
+// Every form of the global allocation functions, so nothing bypasses the count. The
+// deallocation functions must match: memory from malloc goes back through free.
+void* operator new(std::size_t size) { return alloc_counter::Allocate(size); }
+void* operator new[](std::size_t size) { return alloc_counter::Allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return alloc_counter::Allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return alloc_counter::AllocateAligned(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return alloc_counter::AllocateAligned(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return alloc_counter::AllocateAligned(size, static_cast<std::size_t>(alignment));
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { alloc_counter::FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alloc_counter::FreeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { alloc_counter::FreeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { alloc_counter::FreeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { alloc_counter::FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { alloc_counter::FreeAligned(p); }
+#endif
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// Builds with ALLOC_CHECK defined replace the global operator new to count allocations per
+// thread, so the frame loop can check that steady-state frames allocate nothing. Otherwise
+// the standard allocator is left alone: Enabled() is false and the counts stay at zero.
+namespace alloc_counter {
+
+bool Enabled();
+// Allocations made through operator new by the calling thread so far.
+std::uint64_t ThreadAllocations();
+
+}
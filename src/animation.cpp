@@ -0,0 +1,66 @@
+#include "animation.hpp"
+#include <utility>
+
+ClipId AnimationLibrary::Add(TextureHandle textures, float frame_duration, LoopMode loop_mode) {
+    std::vector<float> frame_durations(static_cast<std::size_t>(FrameCount(textures)), frame_duration);
+    return Add(std::move(textures), std::move(frame_durations), loop_mode);
+}
+
+ClipId AnimationLibrary::Add(TextureHandle textures, std::vector<float> frame_durations, LoopMode loop_mode) {
+    if (!HasFrames(textures) || frame_durations.size() != textures->frames.size() || clips_.size() >= kNoClip) {
+        return kNoClip;
+    }
+
+    timings_.push_back(Timing{
+        static_cast<std::uint32_t>(durations_.size()),
+        static_cast<std::uint16_t>(frame_durations.size()),
+        loop_mode
+    });
+    durations_.insert(durations_.end(), frame_durations.begin(), frame_durations.end());
+    clips_.push_back(AnimationClip{std::move(textures), std::move(frame_durations), loop_mode});
+    return static_cast<ClipId>(clips_.size() - 1);
+}
+
+const SpriteFrame* AnimationLibrary::Frame(const AnimationState& state) const {
+    if (state.clip == kNoClip) {
+        return nullptr;
+    }
+    return &clips_[state.clip].textures->frames[state.frame];
+}
+
+void AnimationLibrary::Clear() {
+    clips_.clear();
+    timings_.clear();
+    durations_.clear();
+}
+
+void AdvanceAnimations(Registry* registry, const AnimationLibrary& library, float dt) {
+    const AnimationLibrary::Timing* timings = library.timings_.data();
+    const float* durations = library.durations_.data();
+
+    for (AnimationState& state : registry->animations.Data()) {
+        if (state.clip == kNoClip) {
+            continue;
+        }
+        const AnimationLibrary::Timing& timing = timings[state.clip];
+        state.time += dt;
+        // The time past a frame's end carries into the next, so playback speed does not
+        // depend on dt; a long step passes as many frames as it covers, up to one of each.
+        for (int passed = 0; state.time >= durations[timing.first_duration + state.frame]; ++passed) {
+            if (passed == timing.frame_count) {
+                state.time = 0.0f;  // zero-length frames, or a step longer than the clip
+                break;
+            }
+            if (state.frame + 1 < timing.frame_count) {
+                state.time -= durations[timing.first_duration + state.frame];
+                ++state.frame;
+            } else if (timing.loop_mode == LoopMode::kLoop) {
+                state.time -= durations[timing.first_duration + state.frame];
+                state.frame = 0;
+            } else {
+                state.time = 0.0f;  // holds the last frame
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "registry.hpp"
+#include "texture_set.hpp"
+
+enum class LoopMode : std::uint8_t {
+    kLoop,      // wraps to the first frame
+    kHoldLast,  // stops on the last frame
+};
+
+// Immutable once added: the frames, how long each is shown, and what happens at the end.
+struct AnimationClip {
+    TextureHandle textures{};
+    std::vector<float> frame_durations{};
+    LoopMode loop_mode = LoopMode::kLoop;
+};
+
+// Every clip in the game, shared by all entities that play it. An entity only stores an
+// AnimationState (clip id, frame, time: 8 bytes). Timing is also kept flattened so
+// AdvanceAnimations reads one small record per entity and one float per frame.
+class AnimationLibrary {
+public:
+    // Returns kNoClip, adding nothing, when textures has no frames.
+    ClipId Add(TextureHandle textures, float frame_duration, LoopMode loop_mode);
+    // frame_durations must have one entry per frame.
+    ClipId Add(TextureHandle textures, std::vector<float> frame_durations, LoopMode loop_mode);
+
+    const AnimationClip& Get(ClipId clip) const { return clips_[clip]; }
+    // The frame state is showing, or null for kNoClip.
+    const SpriteFrame* Frame(const AnimationState& state) const;
+    std::size_t Size() const { return clips_.size(); }
+    void Clear();
+
+private:
+    struct Timing {
+        std::uint32_t first_duration;  // into durations_
+        std::uint16_t frame_count;
+        LoopMode loop_mode;
+    };
+
+    friend void AdvanceAnimations(Registry* registry, const AnimationLibrary& library, float dt);
+
+    std::vector<AnimationClip> clips_{};
+    std::vector<Timing> timings_{};
+    std::vector<float> durations_{};
+};
+
+// Moves every entity's animation on by dt in a single pass over the packed AnimationState
+// array. Time past a frame's end carries into the next, so a long step can pass several
+// frames, up to one pass through the clip.
+void AdvanceAnimations(Registry* registry, const AnimationLibrary& library, float dt);
+
+// Switches state to clip from its first frame. Does nothing if clip is already playing,
+// unless restart is set.
+inline void PlayClip(AnimationState* state, ClipId clip, bool restart = false) {
+    if (state->clip != clip || restart) {
+        *state = AnimationState{clip, 0, 0.0f};
+    }
+}
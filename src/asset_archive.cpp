@@ -0,0 +1,176 @@
+#include "asset_archive.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool AssetArchive::Open(const std::string& path) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<std::size_t>(file_size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<std::size_t>(st.st_size);
+#endif
+
+    ArchiveHeader header;
+    if (size_ < sizeof(header)) {
+        std::cerr << "Asset archive " << path << " is truncated\n";
+        Close();
+        return false;
+    }
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, kArchiveMagic, sizeof(header.magic)) != 0 ||
+        header.version != kArchiveVersion ||
+        header.index_offset + std::uint64_t{header.entry_count} * sizeof(ArchiveEntry) > size_ ||
+        header.names_offset + header.names_size > size_) {
+        std::cerr << "Asset archive " << path << " has an unsupported or corrupt header\n";
+        Close();
+        return false;
+    }
+
+    entries_ = reinterpret_cast<const ArchiveEntry*>(data_ + header.index_offset);
+    names_ = reinterpret_cast<const char*>(data_ + header.names_offset);
+    entry_count_ = header.entry_count;
+    for (std::size_t i = 0; i < entry_count_; ++i) {
+        if (entries_[i].data_offset + entries_[i].data_size > size_) {
+            std::cerr << "Asset archive " << path << " has an entry past the end of the file\n";
+            Close();
+            return false;
+        }
+        // Name() and Find() read names straight from the mapping.
+        if (std::uint64_t{entries_[i].name_offset} + entries_[i].name_length > header.names_size) {
+            std::cerr << "Asset archive " << path << " has an entry name past the end of the name table\n";
+            Close();
+            return false;
+        }
+        // The pixels are wrapped in an SDL surface as they are, so its rows must fit the blob.
+        const ArchiveEntry& entry = entries_[i];
+        if (entry.pitch > static_cast<std::uint32_t>(INT_MAX) || std::uint64_t{entry.width} * 4 > entry.pitch ||
+            std::uint64_t{entry.pitch} * entry.height > entry.data_size) {
+            std::cerr << "Asset archive " << path << " has an entry whose pixels do not fit its data\n";
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetArchive::Close() {
+    if (!data_) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    CloseHandle(static_cast<HANDLE>(file_));
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    entries_ = nullptr;
+    names_ = nullptr;
+    entry_count_ = 0;
+}
+
+std::string_view AssetArchive::Name(const ArchiveEntry& entry) const {
+    return std::string_view(names_ + entry.name_offset, entry.name_length);
+}
+
+const ArchiveEntry* AssetArchive::Find(std::string_view name) const {
+    const ArchiveEntry* end = entries_ + entry_count_;
+    const ArchiveEntry* it = std::lower_bound(
+        entries_, end, name,
+        [this](const ArchiveEntry& entry, std::string_view key) { return Name(entry) < key; });
+    return (it != end && Name(*it) == name) ? it : nullptr;
+}
+
+std::vector<const ArchiveEntry*> AssetArchive::FindFrames(std::string_view prefix) const {
+    std::vector<const ArchiveEntry*> frames;
+    const ArchiveEntry* end = entries_ + entry_count_;
+    const ArchiveEntry* it = std::lower_bound(
+        entries_, end, prefix,
+        [this](const ArchiveEntry& entry, std::string_view key) { return Name(entry) < key; });
+
+    for (; it != end; ++it) {
+        const std::string_view name = Name(*it);
+        if (name.compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        // Same directory only, like a non-recursive directory scan.
+        if (name.find('/', prefix.size()) == std::string_view::npos) {
+            frames.push_back(it);
+        }
+    }
+
+    std::stable_sort(frames.begin(), frames.end(), [&](const ArchiveEntry* a, const ArchiveEntry* b) {
+        return FrameIndexAfterPrefix(Name(*a), prefix.size()) < FrameIndexAfterPrefix(Name(*b), prefix.size());
+    });
+    return frames;
+}
+
+std::string ArchiveKey(std::string relative_path_without_extension) {
+    for (char& c : relative_path_without_extension) {
+        c = c == '\\' ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return relative_path_without_extension;
+}
+
+int FrameIndexAfterPrefix(std::string_view name, std::size_t prefix_length) {
+    std::size_t i = prefix_length;
+    int value = 0;
+    bool has_digits = false;
+    while (i < name.size() && std::isdigit(static_cast<unsigned char>(name[i]))) {
+        has_digits = true;
+        value = (value * 10) + (name[i] - '0');
+        ++i;
+    }
+    return has_digits ? value : -1;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// On-disk layout of assets.pak, written by tools/asset_packer.cpp:
+//
+//   ArchiveHeader
+//   ArchiveEntry[entry_count]   sorted by name, so lookups are a binary search
+//   name bytes                  entry names, not NUL-terminated
+//   pixel blobs                 RGBA32 rows, each blob starting on a kArchiveAlignment boundary
+//
+// Names are lower-case paths relative to the assets directory without the extension,
+// e.g. "walk/rewalk3" or "opanda".
+constexpr char kArchiveMagic[4] = {'A', 'P', 'A', 'K'};
+constexpr std::uint32_t kArchiveVersion = 1;
+constexpr std::uint64_t kArchiveAlignment = 4096;
+
+struct ArchiveHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t entry_count;
+    std::uint32_t names_size;
+    std::uint64_t index_offset;
+    std::uint64_t names_offset;
+};
+
+struct ArchiveEntry {
+    std::uint32_t name_offset;  // into the name bytes
+    std::uint32_t name_length;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t pitch;
+    std::uint32_t reserved;
+    std::uint64_t data_offset;  // from the start of the file
+    std::uint64_t data_size;
+};
+
+// Read-only view of a packed archive mapped into memory. Pixels are used in place.
+class AssetArchive {
+public:
+    AssetArchive() = default;
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+    ~AssetArchive() { Close(); }
+
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return data_ != nullptr; }
+
+    const ArchiveEntry* Find(std::string_view name) const;
+    // Entries named <prefix><digits...> with nothing after the prefix's directory, in
+    // numeric frame order, matching what CollectFramesByPrefix returns for loose files.
+    std::vector<const ArchiveEntry*> FindFrames(std::string_view prefix) const;
+
+    std::string_view Name(const ArchiveEntry& entry) const;
+    const void* Pixels(const ArchiveEntry& entry) const { return data_ + entry.data_offset; }
+    std::size_t EntryCount() const { return entry_count_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+    const ArchiveEntry* entries_ = nullptr;
+    const char* names_ = nullptr;
+    std::size_t entry_count_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+// Archive key for a loose file name: lower-case, '/'-separated, extension dropped.
+std::string ArchiveKey(std::string relative_path_without_extension);
+// Numeric frame index following prefix in name, or -1 when there are no digits.
+int FrameIndexAfterPrefix(std::string_view name, std::size_t prefix_length);
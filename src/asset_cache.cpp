@@ -0,0 +1,337 @@
+#include "asset_cache.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+struct DecodedFile {
+    SDL_Surface* surface = nullptr;
+    std::string error;
+};
+
+double SecondsSince(Uint64 start) {
+    return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+           static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+int WorkerCount(std::size_t jobs) {
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<int>(std::min<std::size_t>(hardware, std::max<std::size_t>(jobs, 1)));
+}
+
+// Runs fn(i) for i in [0, count) across worker threads pulling indices from a counter.
+template <typename Fn>
+void ParallelFor(std::size_t count, int workers, Fn&& fn) {
+    std::atomic<std::size_t> next{0};
+    auto work = [&]() {
+        for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (int t = 1; t < workers; ++t) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Reads and decodes one BMP, converted to the atlas pixel format so packing on the main
+// thread is a plain copy. Safe to call from any thread.
+DecodedFile DecodeBMP(const fs::path& path) {
+    PROFILE_SCOPE("DecodeBMP");
+    DecodedFile decoded;
+    SDL_Surface* bmp = SDL_LoadBMP(path.string().c_str());
+    if (!bmp) {
+        decoded.error = SDL_GetError();
+        return decoded;
+    }
+
+    decoded.surface = SDL_ConvertSurfaceFormat(bmp, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!decoded.surface) {
+        decoded.error = SDL_GetError();
+    }
+    SDL_FreeSurface(bmp);
+    return decoded;
+}
+
+// Wraps archived pixels in a surface without copying; the mapping must outlive it.
+DecodedFile WrapArchived(const AssetArchive& archive, const ArchiveEntry& entry) {
+    DecodedFile decoded;
+    decoded.surface = SDL_CreateRGBSurfaceWithFormatFrom(
+        const_cast<void*>(archive.Pixels(entry)), static_cast<int>(entry.width), static_cast<int>(entry.height),
+        32, static_cast<int>(entry.pitch), SDL_PIXELFORMAT_RGBA32);
+    if (!decoded.surface) {
+        decoded.error = SDL_GetError();
+    }
+    return decoded;
+}
+
+// path relative to root, or empty when path lies outside root.
+fs::path RelativeToRoot(const fs::path& path, const fs::path& root) {
+    fs::path relative = path.lexically_normal().lexically_relative(root);
+    if (relative.empty() || *relative.begin() == "..") {
+        return {};
+    }
+    return relative;
+}
+}
+
+void AssetCache::Init(SDL_Renderer* renderer) {
+    Shutdown();
+    atlas_.Init(renderer);
+}
+
+bool AssetCache::OpenArchive(const fs::path& archive_path, const fs::path& assets_dir) {
+    PROFILE_SCOPE("OpenArchive");
+    if (!archive_.Open(archive_path.string())) {
+        return false;
+    }
+    archive_root_ = assets_dir.lexically_normal();
+    std::cout << "Mapped asset archive " << archive_path << " (" << archive_.EntryCount() << " entries)\n";
+    return true;
+}
+
+// Resolves request from the archive index alone; no filesystem calls.
+bool AssetCache::ScanArchive(Request* request) const {
+    if (request->prefixes.empty()) {
+        for (const fs::path& candidate : request->search) {
+            const fs::path relative = RelativeToRoot(candidate, archive_root_);
+            if (relative.empty()) continue;
+
+            const std::string key = ArchiveKey((relative.parent_path() / relative.stem()).generic_string());
+            if (const ArchiveEntry* entry = archive_.Find(key)) {
+                request->archived.push_back(entry);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (const fs::path& dir : request->search) {
+        const fs::path relative = RelativeToRoot(dir, archive_root_);
+        if (relative.empty()) continue;
+
+        const std::string dir_key = relative == "." ? std::string() : ArchiveKey(relative.generic_string()) + "/";
+        for (const std::string& prefix : request->prefixes) {
+            request->archived = archive_.FindFrames(dir_key + prefix);
+            if (!request->archived.empty()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void AssetCache::Store(const std::string& name, TextureSet texture_set) {
+    TextureHandle handle;
+    if (!texture_set.Empty()) {
+        handle = std::make_shared<const TextureSet>(std::move(texture_set));
+    }
+    // Failures are cached too, so asking again does not rescan the disk.
+    entries_[name] = handle;
+}
+
+void AssetCache::RequestImage(const std::string& name, const std::vector<fs::path>& candidates) {
+    pending_.push_back(Request{name, candidates, {}, {}, {}});
+}
+
+void AssetCache::RequestFrames(const std::string& name,
+                               const std::vector<fs::path>& dirs,
+                               const std::vector<std::string>& prefixes) {
+    pending_.push_back(Request{name, dirs, prefixes, {}, {}});
+}
+
+void AssetCache::LoadRequested() {
+    PROFILE_SCOPE("AssetCache::LoadRequested");
+    // Already-loaded names keep their existing entry.
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                  [this](const Request& r) { return entries_.count(r.name) > 0; }),
+                   pending_.end());
+
+    // Phase 1 (workers): resolve each request to its list of files.
+    Uint64 start = SDL_GetPerformanceCounter();
+    ParallelFor(pending_.size(), WorkerCount(pending_.size()), [this](std::size_t i) {
+        PROFILE_SCOPE("ScanRequest");
+        Request& request = pending_[i];
+        if (archive_.IsOpen() && ScanArchive(&request)) {
+            return;
+        }
+        if (request.prefixes.empty()) {
+            for (const fs::path& candidate : request.search) {
+                if (fs::exists(candidate)) {
+                    request.files.push_back(candidate);
+                    break;
+                }
+            }
+            return;
+        }
+
+        for (const fs::path& dir : request.search) {
+            for (const std::string& prefix : request.prefixes) {
+                request.files = CollectFramesByPrefix(dir, prefix);
+                if (!request.files.empty()) {
+                    return;
+                }
+            }
+        }
+    });
+    const double scan_seconds = SecondsSince(start);
+
+    // Phase 2 (workers): read and decode every loose file of every request. Archived
+    // frames are already decoded and only get wrapped, in place, during packing.
+    std::vector<const fs::path*> files;
+    std::size_t archived_count = 0;
+    for (const Request& request : pending_) {
+        for (const fs::path& file : request.files) {
+            files.push_back(&file);
+        }
+        archived_count += request.archived.size();
+    }
+    std::vector<DecodedFile> decoded(files.size());
+    const int decode_workers = WorkerCount(files.size());
+    start = SDL_GetPerformanceCounter();
+    ParallelFor(files.size(), decode_workers, [&](std::size_t i) { decoded[i] = DecodeBMP(*files[i]); });
+    const double decode_seconds = SecondsSince(start);
+
+    // Phase 3 (this thread): pack in request order, so the atlas layout is deterministic.
+    start = SDL_GetPerformanceCounter();
+    std::size_t file_index = 0;
+    for (const Request& request : pending_) {
+        PROFILE_SCOPE("PackRequest");
+        TextureSet texture_set;
+        auto pack = [&](DecodedFile& frame_file, const std::string& source) {
+            if (!frame_file.surface) {
+                std::cerr << "Failed to load " << source << ": " << frame_file.error << "\n";
+                return;
+            }
+
+            if (texture_set.Empty()) {
+                texture_set.width = frame_file.surface->w;
+                texture_set.height = frame_file.surface->h;
+            }
+            texture_set.frames.push_back(atlas_.Add(frame_file.surface));
+            SDL_FreeSurface(frame_file.surface);
+            frame_file.surface = nullptr;
+        };
+
+        for (const ArchiveEntry* entry : request.archived) {
+            DecodedFile frame_file = WrapArchived(archive_, *entry);
+            pack(frame_file, std::string(archive_.Name(*entry)));
+        }
+        for (const fs::path& file : request.files) {
+            pack(decoded[file_index++], file.string());
+        }
+        Store(request.name, std::move(texture_set));
+    }
+    const double pack_seconds = SecondsSince(start);
+
+    start = SDL_GetPerformanceCounter();
+    {
+        PROFILE_SCOPE("UploadAtlas");
+        atlas_.Upload();
+    }
+    const double upload_seconds = SecondsSince(start);
+
+    std::cout << "Loaded " << archived_count << " archived and " << files.size() << " loose files for "
+              << pending_.size() << " assets: "
+              << "scan " << scan_seconds * 1000.0 << " ms, "
+              << "decode " << decode_seconds * 1000.0 << " ms on " << decode_workers << " threads, "
+              << "pack " << pack_seconds * 1000.0 << " ms, "
+              << "upload " << upload_seconds * 1000.0 << " ms\n";
+    pending_.clear();
+}
+
+TextureHandle AssetCache::Get(const std::string& name) const {
+    auto it = entries_.find(name);
+    return it != entries_.end() ? it->second : nullptr;
+}
+
+void AssetCache::Shutdown() {
+    for (const auto& [name, handle] : entries_) {
+        if (handle && handle.use_count() > 1) {
+            std::cerr << "Asset '" << name << "' still referenced at shutdown ("
+                      << handle.use_count() - 1 << " handle(s))\n";
+        }
+    }
+    entries_.clear();
+    pending_.clear();
+    atlas_.Destroy();
+    archive_.Close();
+}
+
+fs::path ResolveAssetsDir() {
+    fs::path exe_dir = fs::current_path();
+    if (char* base = SDL_GetBasePath()) {
+        exe_dir = fs::path(base);
+        SDL_free(base);
+    }
+
+    const std::vector<fs::path> candidates = {
+        exe_dir / "assets",
+        exe_dir / ".." / "assets",
+        fs::current_path() / "assets",
+        fs::current_path() / ".." / "assets"
+    };
+
+    for (const fs::path& path : candidates) {
+        if (fs::exists(path) && fs::is_directory(path)) {
+            return path;
+        }
+    }
+    return candidates[0];
+}
+
+std::vector<fs::path> CollectFramesByPrefix(const fs::path& dir, const std::string& prefix) {
+    std::vector<fs::path> frames;
+    if (!fs::exists(dir) || !fs::is_directory(dir)) {
+        return frames;
+    }
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(dir)) {
+        if (!entry.is_regular_file()) continue;
+
+        const fs::path path = entry.path();
+        std::string stem = path.stem().string();
+        std::string ext = path.extension().string();
+        std::transform(stem.begin(), stem.end(), stem.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        std::transform(ext.begin(), ext.end(), ext.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        if (ext == ".bmp" && stem.rfind(prefix, 0) == 0) {
+            frames.push_back(path);
+        }
+    }
+
+    auto frame_index = [&](const fs::path& p) -> int {
+        const std::string stem = p.stem().string();
+        std::size_t i = prefix.size();
+        int value = 0;
+        bool has_digits = false;
+        while (i < stem.size() && std::isdigit(static_cast<unsigned char>(stem[i]))) {
+            has_digits = true;
+            value = (value * 10) + (stem[i] - '0');
+            ++i;
+        }
+        return has_digits ? value : -1;
+    };
+
+    std::sort(frames.begin(), frames.end(), [&](const fs::path& a, const fs::path& b) {
+        const int ai = frame_index(a);
+        const int bi = frame_index(b);
+        if (ai != bi) return ai < bi;
+        return a.filename().string() < b.filename().string();
+    });
+    return frames;
+}
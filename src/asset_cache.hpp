@@ -0,0 +1,65 @@
+#pragma once
+
+#include <SDL.h>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "asset_archive.hpp"
+#include "texture_atlas.hpp"
+#include "texture_set.hpp"
+
+// Owns every texture the game draws. Assets are keyed by a logical name ("walk",
+// "branch"); each file is decoded and packed into the atlas once, and callers share the
+// result through TextureHandles. GPU memory lives in the atlas pages and is released in
+// Shutdown, regardless of how many handles are still around.
+//
+// Loading is batched: queue everything with Request*, then LoadRequested() scans
+// directories and decodes files on worker threads and packs/uploads on the calling thread.
+// With an archive open, requests under its assets directory are resolved from the
+// archive's index and packed straight from the mapped pixels instead.
+class AssetCache {
+public:
+    void Init(SDL_Renderer* renderer);
+    // Maps a pack built by tools/asset_packer.cpp from assets_dir. Returns false (and loose
+    // files are used) when the archive is missing or invalid.
+    bool OpenArchive(const std::filesystem::path& archive_path, const std::filesystem::path& assets_dir);
+
+    // First existing candidate file becomes the single frame of name.
+    void RequestImage(const std::string& name, const std::vector<std::filesystem::path>& candidates);
+    // Frames <prefix><n>.bmp from the first dir/prefix pair that has any, in numeric order.
+    void RequestFrames(const std::string& name,
+                       const std::vector<std::filesystem::path>& dirs,
+                       const std::vector<std::string>& prefixes);
+    // Loads every pending request and uploads the atlas. Prints per-phase timings.
+    void LoadRequested();
+
+    // Null when name was never loaded or failed to load.
+    TextureHandle Get(const std::string& name) const;
+    void Shutdown();
+
+    const SpriteFrame& WhiteFrame() const { return atlas_.WhiteFrame(); }
+    int PageCount() const { return atlas_.PageCount(); }
+
+private:
+    struct Request {
+        std::string name;
+        std::vector<std::filesystem::path> search;  // candidate files, or dirs when prefixes is set
+        std::vector<std::string> prefixes;
+        std::vector<std::filesystem::path> files;   // filled by the scan phase
+        std::vector<const ArchiveEntry*> archived;  // or these, when found in the archive
+    };
+
+    bool ScanArchive(Request* request) const;
+
+    void Store(const std::string& name, TextureSet texture_set);
+
+    TextureAtlas atlas_{};
+    AssetArchive archive_{};
+    std::filesystem::path archive_root_{};
+    std::vector<Request> pending_{};
+    std::unordered_map<std::string, TextureHandle> entries_{};
+};
+
+std::filesystem::path ResolveAssetsDir();
+std::vector<std::filesystem::path> CollectFramesByPrefix(const std::filesystem::path& dir, const std::string& prefix);
@@ -1,31 +1,52 @@
 #include "audioManager.hpp"
 
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <utility>
+
+namespace {
+// Frames the music thread decodes per step, and how long a swap crossfades.
+constexpr int kMusicBlockFrames = 1024;
+constexpr float kCrossfadeSeconds = 1.5f;
+}
 
 
 AudioManager::AudioManager(
+    const std::filesystem::path& soundsDir,
     int startVolume,
     std::string startingBGM
 ) {
-    audioInit();
+    if (!audioInit()) {
+        return;
+    }
 
-    // Background music
-    BGMList["rain"] = Mix_LoadMUS("../assets/sounds/rainsound.wav");
+    // Background music is streamed, so only the paths are kept.
+    BGMList["rain"] = static_cast<int>(BGMPaths.size());
+    BGMPaths.push_back(soundsDir / "rainsound.wav");
 
     // Sound effects
-    SFXList["walk"]  = Mix_LoadWAV("../assets/sounds/cartoonwalk.wav");
-    SFXList["hurt"]  = Mix_LoadWAV("../assets/sounds/hurt.wav");
-    SFXList["death"] = Mix_LoadWAV("../assets/sounds/Death.wav");
-    SFXList["punch"] = Mix_LoadWAV("../assets/sounds/Punch.wav");
-    SFXList["heel"]  = Mix_LoadWAV("../assets/sounds/heel.wav");
+    loadSFX("walk",  soundsDir / "cartoonwalk.wav");
+    loadSFX("hurt",  soundsDir / "hurt.wav");
+    loadSFX("death", soundsDir / "Death.wav");
+    loadSFX("punch", soundsDir / "Punch.wav");
+    loadSFX("heel",  soundsDir / "heel.wav");
 
     changeVolume(startVolume);
 
     currentMusic = startingBGM;
 
     if (BGMList.count(startingBGM)) {
-        Mix_PlayMusic(BGMList[startingBGM], -1);
+        requestedMusic.store(BGMList[startingBGM], std::memory_order_release);
     }
+
+    musicRing = std::make_unique<MusicRing>();
+    mixer.SetMusicSource(musicRing.get());
+    musicThread = std::thread(&AudioManager::runMusic, this);
+
+    // Effects are loaded and music arrives as soon as its first block decodes.
+    SDL_PauseAudioDevice(device, 0);
 }
 
 
@@ -44,32 +65,169 @@ bool AudioManager::audioInit() {
         return false;
     }
 
-    // Mixer
-    if (Mix_OpenAudio(
-            44100,
-            MIX_DEFAULT_FORMAT,
-            2,
-            2048
-        ) < 0) {
+    SDL_AudioSpec desired{};
+    desired.freq = 44100;
+    desired.format = AUDIO_S16SYS;
+    desired.channels = 2;
+    desired.samples = 2048;
+    desired.callback = audioCallback;
+    desired.userdata = this;
+
+    // No allowed changes: SDL converts to whatever the hardware wants, so the mixer always
+    // produces stereo int16 at 44.1 kHz.
+    device = SDL_OpenAudioDevice(nullptr, 0, &desired, &deviceSpec, 0);
+    if (device == 0) {
+        std::cerr
+            << "Failed to open audio device: "
+            << SDL_GetError()
+            << "\n";
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+
+    return true;
+}
+
+
+void AudioManager::audioCallback(void* userdata, Uint8* stream, int len) {
+    AudioManager* audio = static_cast<AudioManager*>(userdata);
+    const int frames = len / static_cast<int>(2 * sizeof(std::int16_t));
+    audio->mixer.Mix(reinterpret_cast<std::int16_t*>(stream), frames);
+}
+
+
+bool AudioManager::loadWAV(const std::filesystem::path& path, SoundBuffer* buffer) const {
+    SDL_AudioSpec sourceSpec{};
+    Uint8* sourceBuffer = nullptr;
+    Uint32 sourceLength = 0;
+    if (!SDL_LoadWAV(path.string().c_str(), &sourceSpec, &sourceBuffer, &sourceLength)) {
+        std::cerr
+            << "Failed to load "
+            << path
+            << ": "
+            << SDL_GetError()
+            << "\n";
+        return false;
+    }
+
+    SDL_AudioCVT cvt;
+    if (SDL_BuildAudioCVT(&cvt,
+                          sourceSpec.format, sourceSpec.channels, sourceSpec.freq,
+                          deviceSpec.format, deviceSpec.channels, deviceSpec.freq) < 0) {
         std::cerr
-            << "Mixer init failed: "
-            << Mix_GetError()
+            << "Failed to build audio converter: "
+            << SDL_GetError()
             << "\n";
+        SDL_FreeWAV(sourceBuffer);
         return false;
     }
 
-    Mix_AllocateChannels(32);
+    // The conversion runs in place, so the buffer needs room for the larger of the two sizes.
+    std::vector<Uint8> converted(static_cast<std::size_t>(sourceLength) * static_cast<std::size_t>(cvt.len_mult));
+    std::memcpy(converted.data(), sourceBuffer, sourceLength);
+    SDL_FreeWAV(sourceBuffer);
+
+    cvt.len = static_cast<int>(sourceLength);
+    cvt.buf = converted.data();
+    if (SDL_ConvertAudio(&cvt) < 0) {
+        std::cerr
+            << "Failed to convert audio: "
+            << SDL_GetError()
+            << "\n";
+        return false;
+    }
 
+    buffer->samples.resize(static_cast<std::size_t>(cvt.len_cvt) / sizeof(std::int16_t));
+    std::memcpy(buffer->samples.data(), converted.data(), buffer->samples.size() * sizeof(std::int16_t));
     return true;
 }
 
 
-void AudioManager::changeVolume(int volume) {
-    Mix_VolumeMusic(volume);
+void AudioManager::loadSFX(std::string_view name, const std::filesystem::path& path) {
+    SoundBuffer buffer;
+    if (!loadWAV(path, &buffer)) {
+        return;
+    }
 
-    for (auto& [name, sound] : SFXList) {
-        Mix_VolumeChunk(sound, volume);
+    if (findSFX(soundId(name)).valid()) {
+        std::cerr
+            << "Sound id collision for "
+            << name
+            << "\n";
+        return;
     }
+
+    SFXList.push_back(SoundEffect{soundId(name), std::string(name), std::move(buffer)});
+}
+
+
+void AudioManager::runMusic() {
+    MusicDecoder decoders[2];
+    int current = 0;          // decoder feeding the ring; the other one fades in on a swap
+    int playing = -1;         // track decoders[current] holds, -1 for none
+    int fadeFrame = -1;       // frames into the crossfade, -1 when not fading
+    const int fadeFrames = std::max(1, static_cast<int>(kCrossfadeSeconds * deviceSpec.freq));
+
+    std::vector<std::int16_t> outgoing(kMusicBlockFrames * 2);
+    std::vector<std::int16_t> incoming(kMusicBlockFrames * 2);
+
+    while (!stopMusic.load(std::memory_order_acquire)) {
+        const int requested = requestedMusic.load(std::memory_order_acquire);
+        // A request that arrives mid-fade waits for the fade to finish: cutting either
+        // track there would jump its gain and click.
+        if (requested != playing && fadeFrame < 0) {
+            MusicDecoder& next = decoders[1 - current];
+            next.Close();
+            if (requested >= 0) {
+                next.Open(BGMPaths[requested], deviceSpec);
+            }
+            playing = requested;
+            if (decoders[current].IsOpen()) {
+                fadeFrame = 0;
+            } else {
+                // Nothing to fade from, so the track starts at full gain.
+                current = 1 - current;
+            }
+        }
+
+        while (musicRing->FreeSpace() >= outgoing.size()) {
+            // A closed decoder (or a missing file) reads nothing and leaves silence.
+            std::fill(outgoing.begin(), outgoing.end(), 0);
+            decoders[current].Read(outgoing.data(), static_cast<int>(outgoing.size()));
+
+            if (fadeFrame >= 0) {
+                std::fill(incoming.begin(), incoming.end(), 0);
+                decoders[1 - current].Read(incoming.data(), static_cast<int>(incoming.size()));
+                // Equal-power curve, so the overlap does not dip in loudness.
+                for (int frame = 0; frame < kMusicBlockFrames; ++frame) {
+                    const float t = std::min(1.0f, static_cast<float>(fadeFrame + frame) / fadeFrames);
+                    const float outGain = std::cos(t * 1.57079632679f);
+                    const float inGain = std::sin(t * 1.57079632679f);
+                    for (int channel = 0; channel < 2; ++channel) {
+                        const int i = frame * 2 + channel;
+                        const float mixed = outgoing[i] * outGain + incoming[i] * inGain;
+                        outgoing[i] = static_cast<std::int16_t>(std::min(std::max(mixed, -32768.0f), 32767.0f));
+                    }
+                }
+                fadeFrame += kMusicBlockFrames;
+                if (fadeFrame >= fadeFrames) {
+                    decoders[current].Close();
+                    current = 1 - current;
+                    fadeFrame = -1;
+                }
+            }
+
+            musicRing->PushSome(outgoing.data(), outgoing.size());
+        }
+
+        // The ring holds ~185 ms at 44.1 kHz, so waking every 10 ms keeps it well ahead.
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+
+void AudioManager::changeVolume(int volume) {
+    mixer.SetMasterGain(static_cast<float>(volume) / kMaxVolume);
 }
 
 
@@ -88,45 +246,90 @@ void AudioManager::swapBGMusic(const std::string& newMusic) {
 
     currentMusic = newMusic;
 
-    Mix_FadeOutMusic(1000);
-    Mix_FadeInMusic(BGMList[newMusic], -1, 1000);
+    // The music thread notices on its next wake-up and crossfades.
+    requestedMusic.store(BGMList[newMusic], std::memory_order_release);
 }
 
 
-void AudioManager::playSFX(const std::string& audio) {
-    if (!SFXList.count(audio)) {
+SoundHandle AudioManager::findSFX(SoundId id) const {
+    for (std::size_t i = 0; i < SFXList.size(); ++i) {
+        if (SFXList[i].id == id) {
+            return SoundHandle{static_cast<std::uint16_t>(i)};
+        }
+    }
+    return SoundHandle{};
+}
+
+
+bool AudioManager::playSFX(SoundHandle sound, float gain, float pan) {
+    if (!sound.valid() || sound.index >= SFXList.size()) {
+        return false;
+    }
+
+    return mixer.Play(SFXList[sound.index].buffer, gain, pan);
+}
+
+
+bool AudioManager::playSFX(std::string_view audio) {
+    const SoundHandle sound = findSFX(soundId(audio));
+    if (!sound.valid()) {
         std::cerr
             << "Sound not found: "
             << audio
             << "\n";
-        return;
+        return false;
     }
 
-    Mix_PlayChannel(-1, SFXList[audio], 0);
+    return playSFX(sound);
 }
 
 
-Mix_Chunk* AudioManager::getSFX(const std::string& audioName) {
-    if (!SFXList.count(audioName)) {
+const SoundBuffer* AudioManager::getSFX(SoundHandle sound) const {
+    if (!sound.valid() || sound.index >= SFXList.size()) {
         return nullptr;
     }
 
-    return SFXList[audioName];
+    return &SFXList[sound.index].buffer;
 }
 
 
 void AudioManager::audioClean() {
-    for (auto& [name, music] : BGMList) {
-        Mix_FreeMusic(music);
+    if (device == 0) {
+        return;
     }
 
-    for (auto& [name, sound] : SFXList) {
-        Mix_FreeChunk(sound);
+    // Closing the device waits for the callback, so no voice can still point at a buffer.
+    SDL_CloseAudioDevice(device);
+    device = 0;
+
+    if (musicThread.joinable()) {
+        stopMusic.store(true, std::memory_order_release);
+        musicThread.join();
+    }
+
+    if (mixer.MusicUnderruns() > 0) {
+        std::cerr
+            << "Music stream ran dry "
+            << mixer.MusicUnderruns()
+            << " times\n";
+    }
+
+    if (mixer.DroppedVoices() > 0) {
+        std::cerr
+            << "All voices were busy, dropped "
+            << mixer.DroppedVoices()
+            << " sounds\n";
+    }
+
+    if (mixer.DroppedCommands() > 0) {
+        std::cerr
+            << "Sound queue was full, dropped "
+            << mixer.DroppedCommands()
+            << " commands\n";
     }
 
     BGMList.clear();
     SFXList.clear();
 
-    Mix_CloseAudio();
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
-}
\ No newline at end of file
+}
@@ -1,28 +1,93 @@
 #pragma once
 
 #include <SDL.h>
-#include <SDL2/SDL_mixer.h>
 
-#include <string>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
 #include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "mixer.hpp"
+#include "music_stream.hpp"
+
+// Sound effects are named by a 32-bit FNV-1a hash of their name, computed at compile time
+// when the name is a literal, e.g. constexpr SoundId kPunch = soundId("punch").
+using SoundId = std::uint32_t;
+
+constexpr SoundId soundId(std::string_view name) {
+    std::uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
+// Index into the loaded sound effects; resolve once with findSFX and keep it.
+struct SoundHandle {
+    static constexpr std::uint16_t kInvalid = 0xffff;
+    std::uint16_t index = kInvalid;
+
+    bool valid() const { return index != kInvalid; }
+};
+
+// Owns the one audio device. Its callback runs Mixer, which plays every sound effect and
+// the music; the game thread only queues commands. Music is never fully loaded: a decoder
+// thread streams the current track into a ring the mixer reads, crossfading on a swap.
 class AudioManager {
 private:
-    // Background music
-    std::map<std::string, Mix_Music*> BGMList;
+    struct SoundEffect {
+        SoundId id;
+        std::string name;
+        SoundBuffer buffer;
+    };
+
+    // Background music: name -> index into BGMPaths, which the music thread reads
+    std::map<std::string, int> BGMList;
+    std::vector<std::filesystem::path> BGMPaths;
 
-    // Sound effects
-    std::map<std::string, Mix_Chunk*> SFXList;
+    // Sound effects, indexed by SoundHandle
+    std::vector<SoundEffect> SFXList;
 
     // Track currently playing music
     std::string currentMusic = "";
 
+    SDL_AudioDeviceID device = 0;
+    SDL_AudioSpec deviceSpec{};
+    Mixer mixer;
+
+    // Music thread produces, the audio callback consumes. Heap-allocated: it is large.
+    std::unique_ptr<MusicRing> musicRing;
+    std::thread musicThread;
+    std::atomic<bool> stopMusic{false};
+    // Index into BGMPaths the music thread should be playing, or -1 for silence.
+    std::atomic<int> requestedMusic{-1};
+
     // Initialize audio systems
     bool audioInit();
 
+    // Device callback: hands the whole buffer to the mixer.
+    static void audioCallback(void* userdata, Uint8* stream, int len);
+
+    // Decodes a WAV and converts it to the device format.
+    bool loadWAV(const std::filesystem::path& path, SoundBuffer* buffer) const;
+
+    void loadSFX(std::string_view name, const std::filesystem::path& path);
+
+    // Music thread: keeps musicRing topped up and crossfades when requestedMusic changes.
+    void runMusic();
+
 public:
+    static constexpr int kMaxVolume = 128;
+
     // Constructor
     AudioManager(
+        const std::filesystem::path& soundsDir,
         int startVolume = 64,
         std::string startingBGM = "rain"
     );
@@ -30,18 +95,30 @@ public:
     // Destructor
     ~AudioManager();
 
-    // Change overall volume
+    AudioManager(const AudioManager&) = delete;
+    AudioManager& operator=(const AudioManager&) = delete;
+
+    bool isOpen() const { return device != 0; }
+
+    // Change overall volume, 0..kMaxVolume
     void changeVolume(int volume = 64);
 
     // Swap looping background music
     void swapBGMusic(const std::string& newMusic);
 
-    // Play sound effect
-    void playSFX(const std::string& audio);
+    // Look up a sound effect; returns an invalid handle if none has that id.
+    SoundHandle findSFX(SoundId id) const;
+
+    // Queue a sound effect. Wait-free: no lookup, allocation or lock. Must always be called
+    // from the same thread. Returns false if the handle is invalid or the queue is full.
+    bool playSFX(SoundHandle sound, float gain = 1.0f, float pan = 0.0f);
+
+    // Convenience for tools and debugging; hashes the name on every call.
+    bool playSFX(std::string_view audio);
 
-    // Get raw sound effect pointer
-    Mix_Chunk* getSFX(const std::string& audioName);
+    // Get decoded sound effect samples
+    const SoundBuffer* getSFX(SoundHandle sound) const;
 
     // Cleanup
     void audioClean();
-};
\ No newline at end of file
+};
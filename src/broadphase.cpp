@@ -0,0 +1,141 @@
+#include "broadphase.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+std::uint64_t PackKey(BroadphaseLayer layer, std::uint32_t key) {
+    return (static_cast<std::uint64_t>(layer) << 32) | key;
+}
+
+bool Overlaps(const BroadphaseProxy& a, const BroadphaseProxy& b) {
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+}
+
+void Broadphase::Collide(BroadphaseLayer a, BroadphaseLayer b) {
+    masks_[static_cast<int>(a)] |= 1u << static_cast<int>(b);
+    masks_[static_cast<int>(b)] |= 1u << static_cast<int>(a);
+}
+
+void Broadphase::Reserve(std::size_t boxes, std::uint32_t key_limit, std::size_t pairs) {
+    for (std::vector<int>& index_of_key : index_of_key_) {
+        if (index_of_key.size() < key_limit) {
+            index_of_key.resize(key_limit, -1);
+        }
+    }
+    proxies_.reserve(boxes);
+    order_.reserve(boxes);
+    previous_order_.reserve(boxes);
+    placed_.reserve(boxes);
+    pairs_.reserve(pairs);
+}
+
+void Broadphase::Begin() {
+    for (const BroadphaseProxy& proxy : proxies_) {
+        index_of_key_[static_cast<int>(proxy.layer)][proxy.key] = -1;
+    }
+    proxies_.clear();
+    pairs_.clear();
+}
+
+void Broadphase::Add(BroadphaseLayer layer, std::uint32_t key, const SDL_FRect& box) {
+    std::vector<int>& index_of_key = index_of_key_[static_cast<int>(layer)];
+    if (key >= index_of_key.size()) {
+        index_of_key.resize(key + 1, -1);
+    }
+    index_of_key[key] = static_cast<int>(proxies_.size());
+    proxies_.push_back(BroadphaseProxy{box.x, box.y, box.x + box.w, box.y + box.h, layer, key});
+}
+
+void Broadphase::AddPair(int a, int b, std::vector<BroadphasePair>* out) const {
+    if (proxies_[b].layer < proxies_[a].layer) {
+        std::swap(a, b);
+    }
+    out->push_back(BroadphasePair{a, b});
+}
+
+void Broadphase::FindPairs() {
+    // Last tick's order without the boxes that are gone, then the new ones: nearly sorted.
+    order_.clear();
+    placed_.assign(proxies_.size(), 0);
+    for (const std::uint64_t packed : previous_order_) {
+        const std::vector<int>& index_of_key = index_of_key_[packed >> 32];
+        const std::uint32_t key = static_cast<std::uint32_t>(packed);
+        const int index = key < index_of_key.size() ? index_of_key[key] : -1;
+        if (index >= 0 && !placed_[index]) {
+            placed_[index] = 1;
+            order_.push_back(index);
+        }
+    }
+    for (int index = 0; index < static_cast<int>(proxies_.size()); ++index) {
+        if (!placed_[index]) {
+            order_.push_back(index);
+        }
+    }
+
+    for (std::size_t i = 1; i < order_.size(); ++i) {
+        const int index = order_[i];
+        const float left = proxies_[index].left;
+        std::size_t j = i;
+        for (; j > 0 && proxies_[order_[j - 1]].left > left; --j) {
+            order_[j] = order_[j - 1];
+        }
+        order_[j] = index;
+    }
+
+    previous_order_.clear();
+    for (const int index : order_) {
+        previous_order_.push_back(PackKey(proxies_[index].layer, proxies_[index].key));
+    }
+
+    // Everything starting left of a box's right edge, in order, overlaps it on x.
+    for (std::size_t i = 0; i < order_.size(); ++i) {
+        const BroadphaseProxy& a = proxies_[order_[i]];
+        for (std::size_t j = i + 1; j < order_.size() && proxies_[order_[j]].left < a.right; ++j) {
+            const BroadphaseProxy& b = proxies_[order_[j]];
+            if (Collides(a.layer, b.layer) && Overlaps(a, b)) {
+                AddPair(order_[i], order_[j], &pairs_);
+            }
+        }
+    }
+
+    total_pairs_ += pairs_.size();
+    peak_pairs_ = std::max(peak_pairs_, static_cast<int>(pairs_.size()));
+    ++sweeps_;
+}
+
+std::vector<std::uint64_t> Broadphase::CanonicalPairs(const std::vector<BroadphasePair>& pairs) const {
+    // Two packed keys per pair; the lower one first when both sides share a layer.
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> keyed;
+    keyed.reserve(pairs.size());
+    for (const BroadphasePair& pair : pairs) {
+        std::uint64_t a = PackKey(proxies_[pair.a].layer, proxies_[pair.a].key);
+        std::uint64_t b = PackKey(proxies_[pair.b].layer, proxies_[pair.b].key);
+        if (b < a) {
+            std::swap(a, b);
+        }
+        keyed.emplace_back(a, b);
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<std::uint64_t> flat;
+    flat.reserve(keyed.size() * 2);
+    for (const auto& [a, b] : keyed) {
+        flat.push_back(a);
+        flat.push_back(b);
+    }
+    return flat;
+}
+
+bool Broadphase::MatchesBruteForce() const {
+    std::vector<BroadphasePair> brute;
+    for (int a = 0; a < static_cast<int>(proxies_.size()); ++a) {
+        for (int b = a + 1; b < static_cast<int>(proxies_.size()); ++b) {
+            if (Collides(proxies_[a].layer, proxies_[b].layer) && Overlaps(proxies_[a], proxies_[b])) {
+                AddPair(a, b, &brute);
+            }
+        }
+    }
+    return CanonicalPairs(brute) == CanonicalPairs(pairs_);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <SDL.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// What a box belongs to. Pairs are only reported between layers enabled with
+// Broadphase::Collide.
+enum class BroadphaseLayer : std::uint8_t {
+    kPlayerBody,
+    kPlayerAttack,
+    kEnemyBody,
+    kProjectile,
+    kCount,
+};
+
+// key names the owner within its layer (an entity, a pool slot) and must stay the same
+// from tick to tick while the owner lives; that is what lets the x order carry over.
+struct BroadphaseProxy {
+    float left;
+    float top;
+    float right;
+    float bottom;
+    BroadphaseLayer layer;
+    std::uint32_t key;
+};
+
+// Indices into Broadphase::Proxy; a's layer is never after b's.
+struct BroadphasePair {
+    int a;
+    int b;
+};
+
+// Sort-and-sweep on x for boxes that move every tick. Boxes are submitted afresh each tick,
+// but the x order of the tick before is kept by (layer, key) and insertion-sorted, which is
+// close to O(n) in a side-scroller where few boxes pass each other. The sweep then only
+// compares boxes whose x spans overlap, so the cost follows n plus the pairs found rather
+// than n times the number of targets.
+class Broadphase {
+public:
+    // Report overlaps between a and b (a may equal b).
+    void Collide(BroadphaseLayer a, BroadphaseLayer b);
+    // Room for this many boxes, keys below key_limit and pairs, so steady-state ticks do
+    // not allocate.
+    void Reserve(std::size_t boxes, std::uint32_t key_limit, std::size_t pairs);
+
+    // Drops the previous tick's boxes and pairs; their x order is kept for FindPairs.
+    void Begin();
+    // Keys must be unique within a layer for the tick.
+    void Add(BroadphaseLayer layer, std::uint32_t key, const SDL_FRect& box);
+    // Sorts, sweeps and fills Pairs(). Boxes overlap only if their interiors do.
+    void FindPairs();
+
+    const std::vector<BroadphasePair>& Pairs() const { return pairs_; }
+    const BroadphaseProxy& Proxy(int index) const { return proxies_[index]; }
+    int ProxyCount() const { return static_cast<int>(proxies_.size()); }
+
+    // Recomputes the pairs by testing every box against every other and compares them with
+    // Pairs(), ignoring order. O(n^2); for --check-broadphase and benchmarks.
+    bool MatchesBruteForce() const;
+
+    // Candidate pairs over every FindPairs so far, the most any one call produced, and how
+    // many calls that was.
+    std::uint64_t TotalPairs() const { return total_pairs_; }
+    int PeakPairs() const { return peak_pairs_; }
+    int Sweeps() const { return sweeps_; }
+
+private:
+    static constexpr int kLayerCount = static_cast<int>(BroadphaseLayer::kCount);
+
+    bool Collides(BroadphaseLayer a, BroadphaseLayer b) const {
+        return (masks_[static_cast<int>(a)] >> static_cast<int>(b)) & 1u;
+    }
+    // Pairs as (layer, key) of both sides, ordered, for comparing two pair lists.
+    std::vector<std::uint64_t> CanonicalPairs(const std::vector<BroadphasePair>& pairs) const;
+    void AddPair(int a, int b, std::vector<BroadphasePair>* out) const;
+
+    std::array<std::uint32_t, kLayerCount> masks_{};
+    std::vector<BroadphaseProxy> proxies_{};
+    // Per layer, key -> index into proxies_ this tick, or -1.
+    std::array<std::vector<int>, kLayerCount> index_of_key_{};
+    std::vector<int> order_{};  // proxy indices by left edge
+    std::vector<std::uint64_t> previous_order_{};  // (layer, key) of last tick's order_
+    std::vector<unsigned char> placed_{};
+    std::vector<BroadphasePair> pairs_{};
+    std::uint64_t total_pairs_ = 0;
+    int peak_pairs_ = 0;
+    int sweeps_ = 0;
+};
@@ -0,0 +1,71 @@
+#include "collision.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Where origin + t * delta enters and leaves the slab (min, max) on one axis. A segment
+// parallel to the slab is inside it for every t or for none.
+bool Slab(float origin, float delta, float min, float max, float* enter, float* exit) {
+    if (delta == 0.0f) {
+        if (origin <= min || origin >= max) {
+            return false;
+        }
+        *enter = -std::numeric_limits<float>::infinity();
+        *exit = std::numeric_limits<float>::infinity();
+        return true;
+    }
+    const float t0 = (min - origin) / delta;
+    const float t1 = (max - origin) / delta;
+    *enter = std::min(t0, t1);
+    *exit = std::max(t0, t1);
+    return true;
+}
+}
+
+bool RayVsBox(SDL_FPoint origin, SDL_FPoint delta, const SDL_FRect& box, SweepHit* hit) {
+    float enter_x = 0.0f;
+    float exit_x = 0.0f;
+    float enter_y = 0.0f;
+    float exit_y = 0.0f;
+    if (!Slab(origin.x, delta.x, box.x, box.x + box.w, &enter_x, &exit_x) ||
+        !Slab(origin.y, delta.y, box.y, box.y + box.h, &enter_y, &exit_y)) {
+        return false;
+    }
+
+    const float enter = std::max(enter_x, enter_y);
+    const float exit = std::min(exit_x, exit_y);
+    // Only an edge or corner touched, the box is behind the segment, or out of its reach.
+    if (enter >= exit || exit <= 0.0f || enter > 1.0f) {
+        return false;
+    }
+    if (enter < 0.0f) {
+        *hit = SweepHit{0.0f, 0.0f, 0.0f};
+        return true;
+    }
+
+    // Entering through a corner counts as the top or bottom face, so landings win.
+    hit->time = enter;
+    if (enter_x > enter_y) {
+        hit->normal_x = delta.x > 0.0f ? -1.0f : 1.0f;
+        hit->normal_y = 0.0f;
+    } else {
+        hit->normal_x = 0.0f;
+        hit->normal_y = delta.y > 0.0f ? -1.0f : 1.0f;
+    }
+    return true;
+}
+
+bool SweepBox(const SDL_FRect& mover, SDL_FPoint delta, const SDL_FRect& target, SweepHit* hit) {
+    const SDL_FRect grown{target.x - mover.w, target.y - mover.h, target.w + mover.w, target.h + mover.h};
+    return RayVsBox(SDL_FPoint{mover.x, mover.y}, delta, grown, hit);
+}
+
+SDL_Rect SweptBounds(const SDL_FRect& box, SDL_FPoint delta) {
+    const int left = static_cast<int>(std::floor(std::min(box.x, box.x + delta.x))) - 1;
+    const int top = static_cast<int>(std::floor(std::min(box.y, box.y + delta.y))) - 1;
+    const int right = static_cast<int>(std::ceil(std::max(box.x, box.x + delta.x) + box.w)) + 1;
+    const int bottom = static_cast<int>(std::ceil(std::max(box.y, box.y + delta.y) + box.h)) + 1;
+    return SDL_Rect{left, top, right - left, bottom - top};
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SDL.h>
+
+// First contact of something moving in a straight line this tick. time is the fraction of
+// the motion covered before contact, in [0, 1]; the normal is the face that was hit,
+// pointing back at the mover (one of -x, +x, -y, +y). Something that starts inside the
+// box hits at time 0 with a zero normal.
+struct SweepHit {
+    float time = 1.0f;
+    float normal_x = 0.0f;
+    float normal_y = 0.0f;
+};
+
+// Segment from origin to origin + delta against box. Grazing an edge or a face is not a
+// hit; starting on a face and moving into the box is, at time 0.
+bool RayVsBox(SDL_FPoint origin, SDL_FPoint delta, const SDL_FRect& box, SweepHit* hit);
+
+// mover translated by delta against a box that stays put: the mover's top-left corner
+// traced against target grown by the mover's size.
+bool SweepBox(const SDL_FRect& mover, SDL_FPoint delta, const SDL_FRect& target, SweepHit* hit);
+
+// Integer rect holding box at every point along delta, for grid queries. It is a pixel
+// larger all round, so rects the box starts out touching are included.
+SDL_Rect SweptBounds(const SDL_FRect& box, SDL_FPoint delta);
+
+inline SDL_FRect ToFRect(const SDL_Rect& r) {
+    return SDL_FRect{static_cast<float>(r.x), static_cast<float>(r.y), static_cast<float>(r.w),
+                     static_cast<float>(r.h)};
+}
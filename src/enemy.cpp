@@ -1,7 +1,12 @@
 #include "enemy.hpp"
+#include "collision.hpp"
+#include "profiler.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <utility>
+#include <vector>
 
 namespace {
 constexpr int kSquirrelWidth = 44;
@@ -9,186 +14,300 @@ constexpr int kSquirrelHeight = 36;
 constexpr float kShootCooldown = 1.6f;
 constexpr float kHurtCooldown = 0.3f;
 constexpr float kAcornSpeed = 280.0f;
-constexpr float kAcornGravity = 260.0f;
-constexpr int kAcornSize = 12;
 constexpr float kSquirrelAnimFps = 10.0f;
-constexpr float kAcornSpinFps = 12.0f;
+constexpr float kFirstShotDelay = 0.9f;
+constexpr int kSquirrelHits = 2;
+constexpr int kSquirrelGrain = 2048;  // squirrels per parallel chunk
+
+SDL_Rect BodyRect(const Transform& t, const Collider& c) {
+    return SDL_Rect{static_cast<int>(t.x), static_cast<int>(t.y) - c.height, c.width, c.height};
 }
 
-void SquirrelEnemy::SetPosition(float x, float y) {
-    x_ = x;
-    y_ = y;
+// World-space area a squirrel may draw into; the fallback tail sticks out 12px right of
+// and 6px above the body.
+SDL_Rect DrawBounds(const SDL_Rect& body) {
+    return SDL_Rect{body.x, body.y - 6, body.w + 12, body.h + 6};
 }
 
-void SquirrelEnemy::SetTextures(const TextureSet& squirrel_textures, const TextureSet& acorn_textures) {
-    squirrel_textures_ = squirrel_textures;
-    acorn_textures_ = acorn_textures;
+// Aims a shot from the squirrel at t towards the middle of player_rect.
+void AimShot(const Transform& t, const SDL_Rect& player_rect,
+             float* out_x, float* out_y, float* out_vx, float* out_vy) {
+    const float start_x = t.x + (kSquirrelWidth * 0.5f);
+    const float start_y = t.y - (kSquirrelHeight * 0.65f);
+    const float target_x = static_cast<float>(player_rect.x + player_rect.w / 2);
+    const float target_y = static_cast<float>(player_rect.y + player_rect.h / 2);
+    float dx = target_x - start_x;
+    float dy = target_y - start_y;
+    const float length = std::max(std::sqrt(dx * dx + dy * dy), 1.0f);
+    dx /= length;
+    dy /= length;
+
+    *out_x = start_x;
+    *out_y = start_y;
+    *out_vx = dx * kAcornSpeed;
+    *out_vy = dy * kAcornSpeed - 30.0f;
 }
 
-SDL_Rect SquirrelEnemy::GetBodyRect() const {
-    return SDL_Rect{
-        static_cast<int>(x_),
-        static_cast<int>(y_) - kSquirrelHeight,
-        kSquirrelWidth,
-        kSquirrelHeight
-    };
+// Advances a squirrel's timers by its idle time plus step; returns whether it fires now.
+bool TickShooter(ShooterAI* ai, float step) {
+    step += ai->idle_time;
+    ai->idle_time = 0.0f;
+    const bool alive = ai->hits_remaining > 0;
+    ai->hurt_cooldown = std::max(0.0f, ai->hurt_cooldown - step);
+    ai->shot_timer -= alive ? step : 0.0f;
+    if (alive && ai->shot_timer <= 0.0f) {
+        ai->shot_timer = kShootCooldown;
+        return true;
+    }
+    return false;
+}
+
+// Whether a squirrel at x is within near_margin of the view.
+bool IsNear(const SquirrelLod& lod, float x) {
+    return x + kSquirrelWidth >= lod.view_left - lod.near_margin &&
+           x <= lod.view_left + lod.view_width + lod.near_margin;
+}
 }
 
-void SquirrelEnemy::Update(float dt, const SDL_Rect& player_rect) {
-    if (hurt_cooldown_ > 0.0f) {
-        hurt_cooldown_ = std::max(0.0f, hurt_cooldown_ - dt);
+ClipId AddSquirrelClip(AnimationLibrary* library, TextureHandle textures) {
+    return library->Add(std::move(textures), 1.0f / kSquirrelAnimFps, LoopMode::kLoop);
+}
+
+Entity SpawnSquirrel(Registry* registry, float x, float y, ClipId clip) {
+    const Entity entity = registry->Create();
+    registry->transforms.Add(entity, Transform{x, y, x, y});
+    registry->colliders.Add(entity, Collider{kSquirrelWidth, kSquirrelHeight});
+    registry->animations.Add(entity, AnimationState{clip, 0, 0.0f});
+    registry->shooters.Add(entity, ShooterAI{kFirstShotDelay, 0.0f, kSquirrelHits});
+    return entity;
+}
+
+void IndexSquirrels(const Registry& registry, SquirrelLod* lod) {
+    const std::vector<Entity>& owners = registry.shooters.Entities();
+    lod->by_x.clear();
+    for (int i = 0; i < static_cast<int>(owners.size()); ++i) {
+        lod->by_x.emplace_back(registry.transforms.Get(owners[i]).x, i);
     }
+    std::sort(lod->by_x.begin(), lod->by_x.end());
+}
+
+void UpdateSquirrels(Registry* registry, float dt, const SDL_Rect& player_rect, AcornPool* acorns,
+                     JobSystem* jobs, SquirrelLod* lod) {
+    PROFILE_SCOPE("UpdateSquirrels");
+    std::vector<ShooterAI>& shooters = registry->shooters.Data();
+    const std::vector<Entity>& owners = registry->shooters.Entities();
+    const ComponentStore<Transform>& transforms = registry->transforms;
+    const int total = static_cast<int>(shooters.size());
 
-    if (hits_remaining_ > 0) {
-        shot_timer_ -= dt;
-        if (shot_timer_ <= 0.0f) {
-            shot_timer_ = kShootCooldown;
-
-            const float start_x = x_ + (kSquirrelWidth * 0.5f);
-            const float start_y = y_ - (kSquirrelHeight * 0.65f);
-            const float target_x = static_cast<float>(player_rect.x + player_rect.w / 2);
-            const float target_y = static_cast<float>(player_rect.y + player_rect.h / 2);
-            float dx = target_x - start_x;
-            float dy = target_y - start_y;
-            const float length = std::max(std::sqrt(dx * dx + dy * dy), 1.0f);
-            dx /= length;
-            dy /= length;
-
-            AcornProjectile projectile;
-            projectile.x = start_x;
-            projectile.y = start_y;
-            projectile.vx = dx * kAcornSpeed;
-            projectile.vy = dy * kAcornSpeed - 30.0f;
-            projectile.active = true;
-            acorns_.push_back(projectile);
+    // With lod only the squirrels within far_margin of the view are walked, in x order; the
+    // rest are dormant and never touched.
+    const std::pair<float, int>* visited = nullptr;
+    int count = total;
+    if (lod) {
+        if (static_cast<int>(lod->by_x.size()) != total) {
+            IndexSquirrels(*registry, lod);
         }
+        const float reach_left = lod->view_left - lod->far_margin - kSquirrelWidth;
+        const float reach_right = lod->view_left + lod->view_width + lod->far_margin;
+        const auto first = std::lower_bound(lod->by_x.begin(), lod->by_x.end(), reach_left,
+                                            [](const std::pair<float, int>& a, float x) { return a.first < x; });
+        const auto last = std::upper_bound(first, lod->by_x.end(), reach_right,
+                                           [](float x, const std::pair<float, int>& a) { return x < a.first; });
+        visited = lod->by_x.data() + (first - lod->by_x.begin());
+        count = static_cast<int>(last - first);
     }
+    const int chunks = JobSystem::ChunkCount(count, kSquirrelGrain);
 
-    for (AcornProjectile& acorn : acorns_) {
-        if (!acorn.active) {
-            continue;
+    // Only the packed AI timers are read per squirrel; a squirrel looks up its transform
+    // only on the tick it fires. Shots are queued per chunk and spawned afterwards in the
+    // order squirrels were walked, so the acorn pool ends up the same however the chunks
+    // were scheduled.
+    acorns->BeginQueuedShots(chunks, kSquirrelGrain);
+    if (lod) {
+        lod->far_squirrels.Reset(chunks, kSquirrelGrain);
+    }
+    std::atomic<int> near_ticked{0};
+    auto update = [&](int chunk, int begin, int end) {
+        int chunk_near = 0;
+        for (int k = begin; k < end; ++k) {
+            const int i = visited ? visited[k].second : k;
+            ShooterAI& ai = shooters[i];
+            if (lod) {
+                if (!IsNear(*lod, visited[k].first)) {
+                    ai.idle_time += dt;
+                    lod->far_squirrels[chunk].push_back(i);
+                    continue;
+                }
+                ++chunk_near;
+            }
+            if (TickShooter(&ai, dt)) {
+                float x, y, vx, vy;
+                AimShot(transforms.Get(owners[i]), player_rect, &x, &y, &vx, &vy);
+                acorns->QueueShot(chunk, x, y, vx, vy);
+            }
         }
+        near_ticked.fetch_add(chunk_near, std::memory_order_relaxed);
+    };
+    if (jobs) {
+        jobs->ParallelFor(count, kSquirrelGrain, update);
+    } else {
+        update(0, 0, count);
+    }
+    acorns->SpawnQueued();
+    if (!lod) {
+        return;
+    }
 
-        acorn.vy += kAcornGravity * dt;
-        acorn.x += acorn.vx * dt;
-        acorn.y += acorn.vy * dt;
+    // The far slice is a window of the far squirrels in x order, starting where the last one
+    // ended. Squirrels join and leave the far tier as the view moves, so a few wait a
+    // slice longer or shorter than far_interval; their idle time covers the difference.
+    int far_count = 0;
+    lod->far_squirrels.ForEachInOrder([&](int) { ++far_count; });
+    int far_ticked = 0;
+    if (far_count > 0) {
+        const int interval = std::max(lod->far_interval, 1);
+        const int slice = std::min((far_count + interval - 1) / interval, std::max(lod->far_budget, 0));
+        const int first = static_cast<int>(lod->far_cursor % static_cast<std::uint64_t>(far_count));
+        int position = 0;
+        lod->far_squirrels.ForEachInOrder([&](int i) {
+            const int offset = (position++ - first + far_count) % far_count;
+            if (offset >= slice) {
+                return;
+            }
+            // Serial and in x order, so no queue is needed to keep the pool deterministic.
+            if (TickShooter(&shooters[i], 0.0f)) {
+                float x, y, vx, vy;
+                AimShot(transforms.Get(owners[i]), player_rect, &x, &y, &vx, &vy);
+                acorns->Spawn(x, y, vx, vy);
+            }
+        });
+        lod->far_cursor += static_cast<std::uint64_t>(slice);
+        far_ticked = slice;
+    }
 
-        if (acorn.y > 900.0f || acorn.x < -400.0f || acorn.x > 6000.0f) {
-            acorn.active = false;
-        }
+    SquirrelLodStats& last = lod->last_tick;
+    last.near_ticked = static_cast<std::uint64_t>(near_ticked.load(std::memory_order_relaxed));
+    last.far_ticked = static_cast<std::uint64_t>(far_ticked);
+    last.far_waiting = static_cast<std::uint64_t>(far_count - far_ticked);
+    last.dormant = static_cast<std::uint64_t>(total - count);
+    lod->total.near_ticked += last.near_ticked;
+    lod->total.far_ticked += last.far_ticked;
+    lod->total.far_waiting += last.far_waiting;
+    lod->total.dormant += last.dormant;
+    ++lod->ticks;
+}
+
+int HitSquirrels(Registry* registry, const SDL_Rect& attack_rect, JobSystem* jobs) {
+    if (attack_rect.w <= 0 || attack_rect.h <= 0) {
+        return 0;
     }
 
-    acorns_.erase(
-        std::remove_if(acorns_.begin(), acorns_.end(),
-                       [](const AcornProjectile& acorn) { return !acorn.active; }),
-        acorns_.end());
+    const ComponentStore<Transform>& transforms = registry->transforms;
+    const ComponentStore<Collider>& colliders = registry->colliders;
+    std::vector<ShooterAI>& shooters = registry->shooters.Data();
+    const std::vector<Entity>& owners = registry->shooters.Entities();
+    const int attack_right = attack_rect.x + attack_rect.w;
+    const int attack_bottom = attack_rect.y + attack_rect.h;
+
+    // Each squirrel only touches its own AI state; the total is a sum, so order does not matter.
+    std::atomic<int> hits{0};
+    auto hit = [&](int, int begin, int end) {
+        int chunk_hits = 0;
+        for (int i = begin; i < end; ++i) {
+            ShooterAI& ai = shooters[i];
+            if (ai.hits_remaining <= 0 || ai.hurt_cooldown > 0.0f) {
+                continue;
+            }
+
+            const SDL_Rect body = BodyRect(transforms.Get(owners[i]), colliders.Get(owners[i]));
+            if (body.x >= attack_right || body.x + body.w <= attack_rect.x ||
+                body.y >= attack_bottom || body.y + body.h <= attack_rect.y) {
+                continue;
+            }
+
+            --ai.hits_remaining;
+            ai.hurt_cooldown = kHurtCooldown;
+            ++chunk_hits;
+        }
+        hits.fetch_add(chunk_hits, std::memory_order_relaxed);
+    };
+    const int count = static_cast<int>(shooters.size());
+    if (jobs) {
+        jobs->ParallelFor(count, kSquirrelGrain, hit);
+    } else {
+        hit(0, 0, count);
+    }
+    return hits.load(std::memory_order_relaxed);
 }
 
-bool SquirrelEnemy::TryTakeHit(const SDL_Rect& attack_rect) {
-    if (hits_remaining_ <= 0 || hurt_cooldown_ > 0.0f || attack_rect.w <= 0 || attack_rect.h <= 0) {
-        return false;
+void AddSquirrelColliders(const Registry& registry, Broadphase* broadphase) {
+    const std::vector<ShooterAI>& shooters = registry.shooters.Data();
+    const std::vector<Entity>& owners = registry.shooters.Entities();
+    for (std::size_t i = 0; i < shooters.size(); ++i) {
+        if (shooters[i].hits_remaining <= 0) {
+            continue;
+        }
+        const SDL_Rect body = BodyRect(registry.transforms.Get(owners[i]), registry.colliders.Get(owners[i]));
+        broadphase->Add(BroadphaseLayer::kEnemyBody, owners[i], ToFRect(body));
     }
+}
 
-    SDL_Rect enemy_rect = GetBodyRect();
-    if (!SDL_HasIntersection(&enemy_rect, &attack_rect)) {
+bool HitSquirrel(Registry* registry, Entity squirrel) {
+    ShooterAI& ai = registry->shooters.Get(squirrel);
+    if (ai.hits_remaining <= 0 || ai.hurt_cooldown > 0.0f) {
         return false;
     }
-
-    --hits_remaining_;
-    hurt_cooldown_ = kHurtCooldown;
+    --ai.hits_remaining;
+    ai.hurt_cooldown = kHurtCooldown;
     return true;
 }
 
-bool SquirrelEnemy::CheckProjectileHitPlayer(const SDL_Rect& player_rect, float* out_knockback_x) {
-    for (AcornProjectile& acorn : acorns_) {
-        if (!acorn.active) {
+int RenderSquirrels(const Registry& registry, const AnimationLibrary& animations, SpriteBatch* batch,
+                    const SDL_Rect& view, float camera_x) {
+    PROFILE_SCOPE("RenderSquirrels");
+    const std::vector<ShooterAI>& shooters = registry.shooters.Data();
+    const std::vector<Entity>& owners = registry.shooters.Entities();
+
+    int drawn = 0;
+    for (std::size_t i = 0; i < shooters.size(); ++i) {
+        const Entity entity = owners[i];
+        SDL_Rect body = BodyRect(registry.transforms.Get(entity), registry.colliders.Get(entity));
+        const SDL_Rect bounds = DrawBounds(body);
+        if (!SDL_HasIntersection(&bounds, &view)) {
             continue;
         }
+        ++drawn;
 
-        SDL_Rect acorn_rect{
-            static_cast<int>(acorn.x) - (kAcornSize / 2),
-            static_cast<int>(acorn.y) - (kAcornSize / 2),
-            kAcornSize,
-            kAcornSize
-        };
-
-        if (SDL_HasIntersection(&acorn_rect, &player_rect)) {
-            acorn.active = false;
-            if (out_knockback_x) {
-                *out_knockback_x = acorn.vx >= 0.0f ? 180.0f : -180.0f;
-            }
-            return true;
+        const bool alive = shooters[i].hits_remaining > 0;
+        body.x -= static_cast<int>(camera_x);
+        if (const SpriteFrame* frame = animations.Frame(registry.animations.Get(entity))) {
+            // Tint through the vertex colour rather than the texture, which is a shared atlas page.
+            const Uint8 shade = alive ? 255 : 110;
+            batch->Draw(*frame, body, false, SDL_Color{shade, shade, shade, 255});
+            continue;
         }
-    }
-
-    return false;
-}
 
-void SquirrelEnemy::Render(SDL_Renderer* renderer, float camera_x) const {
-    SDL_Rect body = GetBodyRect();
-    body.x -= static_cast<int>(camera_x);
-
-    if (!squirrel_textures_.Empty()) {
-        const Uint32 ticks = SDL_GetTicks();
-        const std::size_t frame_count = squirrel_textures_.frames.size();
-        const std::size_t frame_index =
-            static_cast<std::size_t>((ticks * kSquirrelAnimFps) / 1000.0f) % frame_count;
-        SDL_Texture* squirrel_texture = squirrel_textures_.frames[frame_index];
-        SDL_SetTextureColorMod(
-            squirrel_texture,
-            hits_remaining_ > 0 ? 255 : 110,
-            hits_remaining_ > 0 ? 255 : 110,
-            hits_remaining_ > 0 ? 255 : 110);
-        SDL_RenderCopy(renderer, squirrel_texture, nullptr, &body);
-        SDL_SetTextureColorMod(squirrel_texture, 255, 255, 255);
-    } else {
-        if (hits_remaining_ > 0) {
-            SDL_SetRenderDrawColor(renderer, 150, 92, 48, 255);
+        if (alive) {
+            batch->FillRect(body, SDL_Color{150, 92, 48, 255});
         } else {
-            SDL_SetRenderDrawColor(renderer, 80, 80, 80, 255);
+            batch->FillRect(body, SDL_Color{80, 80, 80, 255});
         }
-        SDL_RenderFillRect(renderer, &body);
 
-        SDL_SetRenderDrawColor(renderer, 225, 210, 185, 255);
         SDL_Rect belly{
             body.x + 8,
             body.y + 10,
             body.w - 16,
             body.h - 12
         };
-        SDL_RenderFillRect(renderer, &belly);
+        batch->FillRect(belly, SDL_Color{225, 210, 185, 255});
 
-        SDL_SetRenderDrawColor(renderer, 110, 60, 32, 255);
         SDL_Rect tail{
             body.x + body.w - 4,
             body.y - 6,
             16,
             28
         };
-        SDL_RenderFillRect(renderer, &tail);
-    }
-
-    for (const AcornProjectile& acorn : acorns_) {
-        if (!acorn.active) {
-            continue;
-        }
-
-        SDL_Rect acorn_rect{
-            static_cast<int>(acorn.x - camera_x) - (kAcornSize / 2),
-            static_cast<int>(acorn.y) - (kAcornSize / 2),
-            kAcornSize,
-            kAcornSize
-        };
-
-        if (!acorn_textures_.Empty()) {
-            const Uint32 ticks = SDL_GetTicks();
-            const std::size_t frame_count = acorn_textures_.frames.size();
-            const std::size_t frame_index =
-                static_cast<std::size_t>((ticks * kAcornSpinFps) / 1000.0f) % frame_count;
-            SDL_RenderCopy(renderer, acorn_textures_.frames[frame_index], nullptr, &acorn_rect);
-        } else {
-            SDL_SetRenderDrawColor(renderer, 122, 75, 34, 255);
-            SDL_RenderFillRect(renderer, &acorn_rect);
-        }
+        batch->FillRect(tail, SDL_Color{110, 60, 32, 255});
     }
+    return drawn;
 }
@@ -1,36 +1,71 @@
 #pragma once
 
 #include <SDL.h>
+#include <cstdint>
+#include <utility>
 #include <vector>
+#include "animation.hpp"
+#include "broadphase.hpp"
+#include "job_system.hpp"
+#include "projectiles.hpp"
+#include "registry.hpp"
+#include "sprite_batch.hpp"
 #include "texture_set.hpp"
 
-struct AcornProjectile {
-    float x = 0.0f;
-    float y = 0.0f;
-    float vx = 0.0f;
-    float vy = 0.0f;
-    bool active = false;
+// Squirrels are entities with a Transform, Collider, AnimationState and ShooterAI; the
+// functions below are the whole of their behaviour. All squirrels play one shared clip.
+ClipId AddSquirrelClip(AnimationLibrary* library, TextureHandle textures);
+Entity SpawnSquirrel(Registry* registry, float x, float y, ClipId clip = kNoClip);
+
+// Squirrels UpdateSquirrels handled in each tier, for one tick or summed over many.
+struct SquirrelLodStats {
+    std::uint64_t near_ticked = 0;
+    std::uint64_t far_ticked = 0;
+    std::uint64_t far_waiting = 0;
+    std::uint64_t dormant = 0;
 };
 
-class SquirrelEnemy {
-public:
-    void SetPosition(float x, float y);
-    void SetTextures(const TextureSet& squirrel_textures, const TextureSet& acorn_textures);
-    void Update(float dt, const SDL_Rect& player_rect);
-    void Render(SDL_Renderer* renderer, float camera_x) const;
-    bool TryTakeHit(const SDL_Rect& attack_rect);
-    bool CheckProjectileHitPlayer(const SDL_Rect& player_rect, float* out_knockback_x) ;
-    bool IsActive() const { return hits_remaining_ > 0; }
-
-private:
-    SDL_Rect GetBodyRect() const;
-
-    float x_ = 0.0f;
-    float y_ = 0.0f;
-    float shot_timer_ = 0.9f;
-    float hurt_cooldown_ = 0.0f;
-    int hits_remaining_ = 2;
-    std::vector<AcornProjectile> acorns_{};
-    TextureSet squirrel_textures_{};
-    TextureSet acorn_textures_{};
+// AI level of detail, by how far a squirrel is outside the view (world x). Within
+// near_margin it ticks every tick. Within far_margin it ticks in round-robin slices, about
+// once every far_interval ticks and at most far_budget squirrels a tick, and catches up on
+// the time it waited when it does. Further out it is dormant: skipped, timers frozen, until
+// the view comes closer; dormant squirrels are not visited at all. The caller sets the view
+// before each tick and calls IndexSquirrels whenever squirrels are spawned or removed.
+struct SquirrelLod {
+    float view_left = 0.0f;
+    float view_width = 0.0f;
+    float near_margin = 128.0f;
+    float far_margin = 512.0f;
+    int far_interval = 4;
+    int far_budget = 64;
+
+    SquirrelLodStats last_tick{};
+    SquirrelLodStats total{};
+    std::uint64_t ticks = 0;
+
+    // (x, store index) of every squirrel, by x. Squirrels never move, so the ones that are
+    // not dormant are found by a binary search on the view.
+    std::vector<std::pair<float, int>> by_x{};
+    std::uint64_t far_cursor = 0;  // round-robin position among the far squirrels
+    ChunkedOutput<int> far_squirrels{};  // this tick's far squirrels, by store index
 };
+
+// Rebuilds lod's x index from the squirrels in registry. Storage is reused, so re-indexing
+// no more squirrels than before does not allocate.
+void IndexSquirrels(const Registry& registry, SquirrelLod* lod);
+
+// Acorns fired this tick are added to the shared pool. With jobs, ranges of squirrels update
+// in parallel and the result is bit-identical to the serial path. Without lod every squirrel
+// ticks every tick.
+void UpdateSquirrels(Registry* registry, float dt, const SDL_Rect& player_rect, AcornPool* acorns,
+                     JobSystem* jobs = nullptr, SquirrelLod* lod = nullptr);
+// Damages every live squirrel touching attack_rect; returns how many were hit.
+int HitSquirrels(Registry* registry, const SDL_Rect& attack_rect, JobSystem* jobs = nullptr);
+// Adds every live squirrel's body to the broadphase as kEnemyBody, keyed by entity.
+void AddSquirrelColliders(const Registry& registry, Broadphase* broadphase);
+// Damages one squirrel the broadphase paired with the attack, unless it is dead or still
+// recovering from the last hit; returns whether it was hit.
+bool HitSquirrel(Registry* registry, Entity squirrel);
+// Draws the squirrels overlapping view (world space) and returns how many that was.
+int RenderSquirrels(const Registry& registry, const AnimationLibrary& animations, SpriteBatch* batch,
+                    const SDL_Rect& view, float camera_x);
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Fixed-capacity array carved out of a FrameArena. Valid until the arena's next Reset.
+template <typename T>
+class ArenaArray {
+public:
+    ArenaArray() = default;
+    ArenaArray(T* data, std::size_t capacity) : data_(data), capacity_(capacity) {}
+
+    // Capacity is decided up front; going past it is a bug, not a reason to grow.
+    void push_back(const T& value) {
+        assert(size_ < capacity_ && "ArenaArray overflow");
+        data_[size_++] = value;
+    }
+    void clear() { size_ = 0; }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](std::size_t i) { return data_[i]; }
+    const T& operator[](std::size_t i) const { return data_[i]; }
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+private:
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+};
+
+// Bump allocator for data that lives for one frame: render lists, hit lists, scratch
+// indices. Allocating is a pointer increment and Reset, at the top of the frame, frees
+// everything at once. Nothing is destroyed, so only trivially destructible types go in.
+//
+// A frame that outgrows the buffer still works: the excess comes from the heap and is
+// freed at Reset. That shows up as a steady-state allocation, which is the cue to raise
+// the capacity.
+class FrameArena {
+public:
+    void Init(std::size_t capacity) {
+        buffer_ = std::make_unique<unsigned char[]>(capacity);
+        capacity_ = capacity;
+        Reset();
+    }
+
+    void Reset() {
+        used_ = 0;
+        overflow_.clear();
+    }
+
+    void* Allocate(std::size_t size, std::size_t alignment) {
+        const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(buffer_.get());
+        const std::size_t offset = ((base + used_ + alignment - 1) & ~(alignment - 1)) - base;
+        if (offset + size <= capacity_) {
+            used_ = offset + size;
+            high_water_ = used_ > high_water_ ? used_ : high_water_;
+            return buffer_.get() + offset;
+        }
+        overflow_.push_back(std::make_unique<std::max_align_t[]>(
+            (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)));
+        ++overflows_;
+        return overflow_.back().get();
+    }
+
+    template <typename T>
+    ArenaArray<T> MakeArray(std::size_t capacity) {
+        static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "overflow blocks are only max_align_t aligned");
+        return ArenaArray<T>(static_cast<T*>(Allocate(capacity * sizeof(T), alignof(T))), capacity);
+    }
+
+    std::size_t Used() const { return used_; }
+    std::size_t Capacity() const { return capacity_; }
+    // Most bytes any frame has used, and how many allocations did not fit.
+    std::size_t HighWater() const { return high_water_; }
+    int Overflows() const { return overflows_; }
+
+private:
+    std::unique_ptr<unsigned char[]> buffer_{};
+    std::size_t capacity_ = 0;
+    std::size_t used_ = 0;
+    std::size_t high_water_ = 0;
+    int overflows_ = 0;
+    std::vector<std::unique_ptr<std::max_align_t[]>> overflow_{};
+};
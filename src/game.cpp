@@ -1,7 +1,10 @@
 #include "game.hpp"
-#include "platform.hpp"
+#include "alloc_counter.hpp"
+#include "collision.hpp"
+#include "profiler.hpp"
 #include <algorithm>
-#include <cctype>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -13,516 +16,904 @@ namespace fs = std::filesystem;
 static const int kWindowWidth = 960;
 static const int kWindowHeight = 540;
 
-static SDL_Texture* LoadTextureBMP(SDL_Renderer* renderer, const fs::path& path, int* out_w, int* out_h) {
-    if (!fs::exists(path)) {
-        std::cerr << "File not found: " << path << "\n";
-        return nullptr;
-    }
-
-    SDL_Surface* bmp = SDL_LoadBMP(path.string().c_str());
-    if (!bmp) {
-        std::cerr << "Failed to load " << path << ": " << SDL_GetError() << "\n";
-        return nullptr;
-    }
-
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, bmp);
-    if (texture && out_w && out_h) {
-        *out_w = bmp->w;
-        *out_h = bmp->h;
-    }
-
-    SDL_FreeSurface(bmp);
-    return texture;
-}
-
-static TextureSet LoadSingleTexture(SDL_Renderer* renderer, const fs::path& path) {
-    TextureSet texture_set;
-    SDL_Texture* texture = LoadTextureBMP(renderer, path, &texture_set.width, &texture_set.height);
-    if (texture) {
-        texture_set.frames.push_back(texture);
-    }
-    return texture_set;
-}
-
-static TextureSet LoadSingleTexture(SDL_Renderer* renderer,
-                                    const std::vector<fs::path>& candidate_paths,
-                                    fs::path* out_loaded_path = nullptr) {
-    for (const fs::path& candidate : candidate_paths) {
-        TextureSet texture_set = LoadSingleTexture(renderer, candidate);
-        if (!texture_set.Empty()) {
-            if (out_loaded_path) {
-                *out_loaded_path = candidate;
-            }
-            return texture_set;
-        }
-    }
-    return {};
-}
-
-static TextureSet LoadTextureSet(SDL_Renderer* renderer, const std::vector<fs::path>& frame_paths) {
-    TextureSet texture_set;
-    for (const fs::path& frame_path : frame_paths) {
-        int frame_w = 0;
-        int frame_h = 0;
-        SDL_Texture* frame = LoadTextureBMP(renderer, frame_path, &frame_w, &frame_h);
-        if (!frame) {
-            continue;
-        }
-
-        if (texture_set.Empty()) {
-            texture_set.width = frame_w;
-            texture_set.height = frame_h;
-        }
-        texture_set.frames.push_back(frame);
-    }
-    return texture_set;
-}
-
-static void DestroyTextureSet(TextureSet& texture_set) {
-    for (SDL_Texture* texture : texture_set.frames) {
-        if (texture) {
-            SDL_DestroyTexture(texture);
+// Simulation runs at a fixed rate (GameOptions::tick_rate); rendering interpolates
+// between the last two ticks.
+static const int kMaxStepsPerFrame = 8;
+static const double kMaxFrameTime = 0.25;
+
+// Seconds each frame of the player's clips is shown.
+static const float kIdleFrameDuration = 0.12f;
+static const float kWalkFrameDuration = 0.10f;
+static const float kPunchFrameDuration = 0.06f;
+static const float kJumpFrameDuration = 0.08f;
+static const float kHeelKickFrameDuration = 0.05f;
+
+// Transient data of one frame; the high-water mark is printed at exit.
+static const std::size_t kFrameArenaBytes = 256 * 1024;
+// Entities the registry is sized for up front; the resident level holds far fewer.
+static const std::size_t kReservedEntities = 4096;
+// Candidate pairs the broadphase holds before it has to grow.
+static const std::size_t kReservedCollisionPairs = 1024;
+// Input changes a recording holds before it has to grow.
+static const std::size_t kReservedInputChanges = 1 << 16;
+// Frames that may still allocate while containers grow to their working sizes.
+static const std::uint64_t kAllocationWarmupFrames = 240;
+
+bool Game::Init(const GameOptions& options) {
+    options_ = options;
+    profiler::SetEnabled(!options_.trace_path.empty());
+    jobs_.Init(options_.single_thread ? 0 : JobSystem::DefaultWorkerThreads());
+    frame_arena_.Init(kFrameArenaBytes);
+    registry_.Reserve(kReservedEntities);
+    broadphase_.Collide(BroadphaseLayer::kPlayerAttack, BroadphaseLayer::kEnemyBody);
+    broadphase_.Collide(BroadphaseLayer::kPlayerBody, BroadphaseLayer::kProjectile);
+    broadphase_.Reserve(kReservedEntities + AcornPool::kCapacity,
+                        static_cast<std::uint32_t>(std::max<std::size_t>(kReservedEntities, AcornPool::kCapacity)),
+                        kReservedCollisionPairs);
+    if (!options_.record_path.empty()) {
+        recorder_.Reserve(kReservedInputChanges);
+    }
+    if (!options_.replay_path.empty()) {
+        if (!replay_.Load(options_.replay_path)) {
+            return false;
         }
+        options_.tick_rate = static_cast<int>(replay_.TickRate());
+        options_.ai_budget = static_cast<int>(replay_.AiBudget());
     }
-    texture_set.frames.clear();
-    texture_set.width = 0;
-    texture_set.height = 0;
-}
-
-static fs::path ResolveAssetsDir() {
-    fs::path exe_dir = fs::current_path();
-    if (char* base = SDL_GetBasePath()) {
-        exe_dir = fs::path(base);
-        SDL_free(base);
-    }
-
-    const std::vector<fs::path> candidates = {
-        exe_dir / "assets",
-        exe_dir / ".." / "assets",
-        fs::current_path() / "assets",
-        fs::current_path() / ".." / "assets"
-    };
-
-    for (const fs::path& path : candidates) {
-        if (fs::exists(path) && fs::is_directory(path)) {
-            return path;
-        }
-    }
-    return candidates[0];
-}
-
-static std::vector<fs::path> CollectFramesByPrefix(const fs::path& dir, const std::string& prefix) {
-    std::vector<fs::path> frames;
-    if (!fs::exists(dir) || !fs::is_directory(dir)) {
-        return frames;
+    if (options_.tick_rate <= 0) {
+        std::cerr << "Tick rate must be positive, got " << options_.tick_rate << "\n";
+        return false;
     }
-
-    for (const fs::directory_entry& entry : fs::directory_iterator(dir)) {
-        if (!entry.is_regular_file()) continue;
-
-        const fs::path path = entry.path();
-        std::string stem = path.stem().string();
-        std::string ext = path.extension().string();
-        std::transform(stem.begin(), stem.end(), stem.begin(),
-                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-        std::transform(ext.begin(), ext.end(), ext.begin(),
-                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-
-        if (ext == ".bmp" && stem.rfind(prefix, 0) == 0) {
-            frames.push_back(path);
-        }
+    fixed_dt_ = 1.0 / options_.tick_rate;
+    if (options_.ai_budget < 0) {
+        std::cerr << "AI budget must not be negative, got " << options_.ai_budget << "\n";
+        return false;
     }
-
-    auto frame_index = [&](const fs::path& p) -> int {
-        const std::string stem = p.stem().string();
-        std::size_t i = prefix.size();
-        int value = 0;
-        bool has_digits = false;
-        while (i < stem.size() && std::isdigit(static_cast<unsigned char>(stem[i]))) {
-            has_digits = true;
-            value = (value * 10) + (stem[i] - '0');
-            ++i;
-        }
-        return has_digits ? value : -1;
-    };
-
-    std::sort(frames.begin(), frames.end(), [&](const fs::path& a, const fs::path& b) {
-        const int ai = frame_index(a);
-        const int bi = frame_index(b);
-        if (ai != bi) return ai < bi;
-        return a.filename().string() < b.filename().string();
-    });
-    return frames;
-}
-
-static std::vector<fs::path> CollectFramesByPrefix(const std::vector<fs::path>& dirs, const std::string& prefix) {
-    for (const fs::path& dir : dirs) {
-        std::vector<fs::path> frames = CollectFramesByPrefix(dir, prefix);
-        if (!frames.empty()) {
-            return frames;
-        }
+    squirrel_lod_.far_budget = options_.ai_budget;
+    squirrel_lod_.by_x.reserve(kReservedEntities);
+    if (options_.check_snapshot && (!options_.record_path.empty() || !options_.replay_path.empty())) {
+        std::cerr << "--check-snapshot runs scripted input and cannot record or replay\n";
+        return false;
     }
-    return {};
-}
 
-bool Game::Init() {
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0) {
+    // Headless runs only decode assets, so they need no video or event subsystem.
+    const Uint32 subsystems = options_.headless ? 0 : (SDL_INIT_VIDEO | SDL_INIT_EVENTS);
+    if (SDL_Init(subsystems) != 0) {
         std::cerr << "SDL_Init failed: " << SDL_GetError() << "\n";
         return false;
     }
 
-    window_ = SDL_CreateWindow("Angry Panda",
-                               SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                               kWindowWidth, kWindowHeight,
-                               SDL_WINDOW_SHOWN);
-    if (!window_) {
-        std::cerr << "SDL_CreateWindow failed: " << SDL_GetError() << "\n";
-        return false;
-    }
+    if (!options_.headless) {
+        window_ = SDL_CreateWindow("Angry Panda",
+                                   SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                   kWindowWidth, kWindowHeight,
+                                   SDL_WINDOW_SHOWN);
+        if (!window_) {
+            std::cerr << "SDL_CreateWindow failed: " << SDL_GetError() << "\n";
+            return false;
+        }
 
-    renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    if (!renderer_) {
-        std::cerr << "SDL_CreateRenderer failed: " << SDL_GetError() << "\n";
-        return false;
+        const Uint32 renderer_flags = options_.software_renderer
+                                          ? (SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE)
+                                          : (SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        renderer_ = SDL_CreateRenderer(window_, -1, renderer_flags);
+        if (!renderer_) {
+            std::cerr << "SDL_CreateRenderer failed: " << SDL_GetError() << "\n";
+            return false;
+        }
     }
 
     fs::path assets_dir = ResolveAssetsDir();
+    assets_.Init(renderer_);
+    // The packed archive is produced by the build; loose files are the fallback.
+    assets_.OpenArchive(assets_dir / "assets.pak", assets_dir);
 
+    // Each asset is decoded once and shared by handle; names are the cache keys.
     fs::path player_path = assets_dir / "Opanda.bmp";
-    player_texture_ = LoadSingleTexture(renderer_, player_path);
-    fs::path platform_path = assets_dir / "branch.bmp";
-    platform_textures_ = LoadSingleTexture(renderer_, platform_path);
-    fs::path background_path = assets_dir / "Background.bmp";
-    background_texture_ = LoadSingleTexture(renderer_, background_path);
-    fs::path tree_path = assets_dir / "tree.bmp";
-    tree_texture_ = LoadSingleTexture(renderer_, tree_path);
-    fs::path bush_path = assets_dir / "bush.bmp";
-    bush_texture_ = LoadSingleTexture(renderer_, bush_path);
-    if (player_texture_.Empty()) {
-        std::cerr << "Failed to load " << player_path << "\n";
-    } else {
-        player_.SetTexture(player_texture_);
-    }
-
     fs::path idle_dir = assets_dir / "idel";
-    std::vector<fs::path> idle_frames = CollectFramesByPrefix(idle_dir, "idel");
-    if (idle_frames.empty()) {
-        idle_frames = CollectFramesByPrefix(idle_dir, "idel");
-    }
-    if (idle_frames.empty()) {
-        idle_frames = CollectFramesByPrefix(assets_dir, "idel");
-    }
-    idle_textures_ = LoadTextureSet(renderer_, idle_frames);
-
     fs::path walk_dir = assets_dir / "walk";
-    std::vector<fs::path> walk_frames = CollectFramesByPrefix(walk_dir, "walk");
-    if (walk_frames.empty()) {
-        walk_frames = CollectFramesByPrefix(walk_dir, "rewalk");
-    }
-    if (walk_frames.empty()) {
-        walk_frames = CollectFramesByPrefix(assets_dir, "rewalk");
-    }
-    walk_textures_ = LoadTextureSet(renderer_, walk_frames);
-
     fs::path jump_dir = assets_dir / "jump";
-    std::vector<fs::path> jump_frames = CollectFramesByPrefix(jump_dir, "jump");
-    if (jump_frames.empty()) {
-        jump_frames = CollectFramesByPrefix(assets_dir, "jump");
-    }
-    jump_textures_ = LoadTextureSet(renderer_, jump_frames);
-
     fs::path punch_dir = assets_dir / "punch";
-    std::vector<fs::path> punch_frames = CollectFramesByPrefix(punch_dir, "punch");
-    if (punch_frames.empty()) {
-        punch_frames = CollectFramesByPrefix(assets_dir, "punch");
-    }
-    punch_textures_ = LoadTextureSet(renderer_, punch_frames);
-
     fs::path heel_kick_dir = assets_dir / "heel";
-    std::vector<fs::path> heel_kick_frames = CollectFramesByPrefix(heel_kick_dir, "heel");
-    if (heel_kick_frames.empty()) {
-        heel_kick_frames = CollectFramesByPrefix(assets_dir, "heel");
-    }
-    heel_kick_textures_ = LoadTextureSet(renderer_, heel_kick_frames);
 
-    
-    background_texture_ = LoadSingleTexture(
-        renderer_,
+    assets_.RequestImage("player", {player_path});
+    assets_.RequestFrames("idle", {idle_dir, assets_dir}, {"idel"});
+    assets_.RequestFrames("walk", {walk_dir, assets_dir}, {"walk", "rewalk"});
+    assets_.RequestFrames("jump", {jump_dir, assets_dir}, {"jump"});
+    assets_.RequestFrames("punch", {punch_dir, assets_dir}, {"punch"});
+    assets_.RequestFrames("heel", {heel_kick_dir, assets_dir}, {"heel"});
+    assets_.RequestImage(
+        "background",
         {
             assets_dir / "background" / "Background.bmp",
             assets_dir / "Background.bmp"
-        },
-        &background_path);
-
-    
-    tree_texture_ = LoadSingleTexture(
-        renderer_,
+        });
+    assets_.RequestImage(
+        "tree",
         {
             assets_dir / "tree" / "tree.bmp",
             assets_dir / "tree.bmp"
-        },
-        &tree_path);
-
-    
-    bush_texture_ = LoadSingleTexture(
-        renderer_,
+        });
+    assets_.RequestImage(
+        "bush",
         {
             assets_dir / "tree" / "bush.bmp",
             assets_dir / "bush.bmp"
-        },
-        &bush_path);
-
-    
-    platform_textures_ = LoadSingleTexture(
-        renderer_,
+        });
+    assets_.RequestImage(
+        "branch",
         {
             assets_dir / "tree" / "branch.bmp",
             assets_dir / "branch.bmp"
-        },
-        &platform_path);
-
-    std::vector<fs::path> squirrel_frames = CollectFramesByPrefix(
-        std::vector<fs::path>{
-            assets_dir / "squirrelshot",
-            assets_dir
-        },
-        "shoot");
-    squirrel_textures_ = LoadTextureSet(renderer_, squirrel_frames);
-
-    std::vector<fs::path> acorn_frames = CollectFramesByPrefix(
-        std::vector<fs::path>{
-            assets_dir / "acorn",
-            assets_dir
-        },
-        "acorn");
-    acorn_textures_ = LoadTextureSet(renderer_, acorn_frames);
-
-    if (!idle_textures_.Empty()) {
-        player_.SetIdleTextures(idle_textures_);
-        std::cout << "Loaded idle frames: " << idle_textures_.frames.size() << "\n";
+        });
+    assets_.RequestFrames("squirrel", {assets_dir / "squirrelshot", assets_dir}, {"shoot"});
+    assets_.RequestFrames("acorn", {assets_dir / "acorn", assets_dir}, {"acorn"});
+    assets_.LoadRequested();
+
+    if (!level_.Open({assets_dir / "level", assets_dir}, kWindowHeight)) {
+        return false;
+    }
+
+    sprite_batch_.SetWhiteFrame(assets_.WhiteFrame());
+    if (renderer_) {
+        // One screen for the background, camera-width tiles for the scenery layers.
+        layers_available_ = backdrop_.Init(renderer_, kWindowWidth, kWindowHeight) &&
+                            back_scenery_.Init(renderer_, kWindowWidth, kWindowHeight) &&
+                            front_scenery_.Init(renderer_, kWindowWidth, kWindowHeight);
+        layer_cache_ = options_.layer_cache && layers_available_;
+        if (options_.layer_cache && !layers_available_) {
+            std::cerr << "Render targets unavailable, drawing scenery every frame\n";
+        }
+    }
+    std::cout << "Packed sprites into " << assets_.PageCount() << " atlas page(s)\n";
+
+    // The player entity has to exist before SetTexture sizes its collider from the sprite.
+    player_.Attach(&registry_);
+    player_.SetGroundY(kWindowHeight - 40.0f);
+    player_.SetPosition(120.0f, kWindowHeight - 80.0f);
+
+    TextureHandle player_texture = assets_.Get("player");
+    if (!HasFrames(player_texture)) {
+        std::cerr << "Failed to load " << player_path << "\n";
+    } else {
+        player_.SetTexture(player_texture);
+    }
+
+    TextureHandle idle_textures = assets_.Get("idle");
+    TextureHandle walk_textures = assets_.Get("walk");
+    TextureHandle jump_textures = assets_.Get("jump");
+    TextureHandle punch_textures = assets_.Get("punch");
+    TextureHandle heel_kick_textures = assets_.Get("heel");
+    TextureHandle acorn_textures = assets_.Get("acorn");
+    background_texture_ = assets_.Get("background");
+    tree_texture_ = assets_.Get("tree");
+    bush_texture_ = assets_.Get("bush");
+    platform_textures_ = assets_.Get("branch");
+    TextureHandle squirrel_textures = assets_.Get("squirrel");
+
+    // Locomotion loops; attacks and the jump play once and hold their last frame.
+    PlayerClips player_clips;
+    player_clips.idle = animations_.Add(idle_textures, kIdleFrameDuration, LoopMode::kLoop);
+    player_clips.walk = animations_.Add(walk_textures, kWalkFrameDuration, LoopMode::kLoop);
+    player_clips.jump = animations_.Add(jump_textures, kJumpFrameDuration, LoopMode::kHoldLast);
+    player_clips.punch = animations_.Add(punch_textures, kPunchFrameDuration, LoopMode::kHoldLast);
+    player_clips.heel_kick = animations_.Add(heel_kick_textures, kHeelKickFrameDuration, LoopMode::kHoldLast);
+    squirrel_clip_ = AddSquirrelClip(&animations_, squirrel_textures);
+
+    if (HasFrames(idle_textures)) {
+        std::cout << "Loaded idle frames: " << FrameCount(idle_textures) << "\n";
     } else {
         std::cerr << "No idle frames found in " << idle_dir << "\n";
     }
 
-    if (!walk_textures_.Empty()) {
-        player_.SetWalkTextures(walk_textures_);
-        std::cout << "Loaded walk frames: " << walk_textures_.frames.size() << "\n";
+    if (HasFrames(walk_textures)) {
+        std::cout << "Loaded walk frames: " << FrameCount(walk_textures) << "\n";
     } else {
         std::cerr << "No walk frames found in " << walk_dir << "\n";
     }
-    if (!jump_textures_.Empty()) {
-        player_.SetJumpTextures(jump_textures_);
-        std::cout << "Loaded jump frames: " << jump_textures_.frames.size() << "\n";
+    if (HasFrames(jump_textures)) {
+        std::cout << "Loaded jump frames: " << FrameCount(jump_textures) << "\n";
     } else {
         std::cerr << "No jump frames found in " << jump_dir << "\n";}
-    if (!punch_textures_.Empty()) {
-        player_.SetPunchTextures(punch_textures_);
-        std::cout << "Loaded punch frames: " << punch_textures_.frames.size() << "\n";
+    if (HasFrames(punch_textures)) {
+        std::cout << "Loaded punch frames: " << FrameCount(punch_textures) << "\n";
     } else {
         std::cerr << "No punch frames found in " << punch_dir << "\n";
     }
-    if (!heel_kick_textures_.Empty()) {
-        player_.SetHeelKickTextures(heel_kick_textures_);
-        std::cout << "Loaded heel kick frames: " << heel_kick_textures_.frames.size() << "\n";
+    if (HasFrames(heel_kick_textures)) {
+        std::cout << "Loaded heel kick frames: " << FrameCount(heel_kick_textures) << "\n";
     } else {
         std::cerr << "No heel kick frames found in " << heel_kick_dir << " (or flipkick prefix)\n";
     }
-    if (background_texture_.Empty()) {
+    if (!HasFrames(background_texture_)) {
         std::cerr << "No background texture found under " << assets_dir << "\n";
     }
-    if (tree_texture_.Empty()) {
+    if (!HasFrames(tree_texture_)) {
         std::cerr << "No tree texture found under " << assets_dir << "\n";
     }
-    if (bush_texture_.Empty()) {
+    if (!HasFrames(bush_texture_)) {
         std::cerr << "No bush texture found under " << assets_dir << "\n";
     }
-    if (platform_textures_.Empty()) {
+    if (!HasFrames(platform_textures_)) {
         std::cerr << "No branch texture found under " << assets_dir << "\n";
     }
-    if (squirrel_textures_.Empty()) {
+    if (!HasFrames(squirrel_textures)) {
         std::cerr << "No squirrel frames found under " << assets_dir << "\n";
     }
-    if (acorn_textures_.Empty()) {
+    if (!HasFrames(acorn_textures)) {
         std::cerr << "No acorn frames found under " << assets_dir << "\n";
     }
 
-    player_.SetGroundY(kWindowHeight - 40.0f);
-    player_.SetPosition(120.0f, kWindowHeight - 80.0f);
+    player_.SetAnimations(&animations_, player_clips);
 
-    //platforms
-    platforms_.push_back({ SDL_Rect{0, kWindowHeight - 40, 5000, 40} });  // ground
+    acorns_.SetTextures(acorn_textures);
 
-    platforms_.push_back({ SDL_Rect{300, 400, 200, 50} });
-    platforms_.push_back({ SDL_Rect{600, 300, 200, 50} });
-    platforms_.push_back({ SDL_Rect{300, 250, 200, 50} });
-    platforms_.push_back({ SDL_Rect{600, 150, 200, 50} });
-
-    SquirrelEnemy lower_squirrel;
-    lower_squirrel.SetPosition(360.0f, 400.0f);
-    lower_squirrel.SetTextures(squirrel_textures_, acorn_textures_);
-    squirrels_.push_back(lower_squirrel);
-
-    SquirrelEnemy upper_squirrel;
-    upper_squirrel.SetPosition(640.0f, 150.0f);
-    upper_squirrel.SetTextures(squirrel_textures_, acorn_textures_);
-    squirrels_.push_back(upper_squirrel);
+    camera_x_ = player_.GetX() - 480;
+    prev_camera_x_ = camera_x_;
+    StreamLevel();
 
     running_ = true;
     return true;
 }
 // Game loop
 void Game::Run() {
-    Uint64 now = SDL_GetPerformanceCounter();
-    Uint64 last = now;
+    const double freq = static_cast<double>(SDL_GetPerformanceFrequency());
+    Uint64 last = SDL_GetPerformanceCounter();
+    double accumulator = 0.0;
 
     while (running_) {
+        PROFILE_SCOPE("Frame");
+        BeginFrame();
+        const Uint64 now = SDL_GetPerformanceCounter();
+        const double frame_time = static_cast<double>(now - last) / freq;
         last = now;
-        now = SDL_GetPerformanceCounter();
-        double freq = static_cast<double>(SDL_GetPerformanceFrequency());
-        float dt = static_cast<float>((now - last) / freq);
+        profiler::AddFrameTime(frame_time);
 
-        HandleEvents();
-        Update(dt);     
-        Render();       
+        // A long hitch (window drag, breakpoint) must not turn into one huge step.
+        accumulator += std::min(frame_time, kMaxFrameTime);
+
+        {
+            PROFILE_SCOPE("HandleEvents");
+            HandleEvents();
+        }
+
+        int steps = 0;
+        while (accumulator >= fixed_dt_ && steps < kMaxStepsPerFrame && !ReplayFinished()) {
+            PROFILE_SCOPE("Update");
+            Step();
+            accumulator -= fixed_dt_;
+            ++steps;
+        }
+        if (ReplayFinished()) {
+            running_ = false;
+        }
+
+        // Still behind after the catch-up cap: drop the backlog instead of spiralling.
+        if (accumulator >= fixed_dt_) {
+            accumulator = std::fmod(accumulator, fixed_dt_);
+        }
+
+        Render(static_cast<float>(accumulator / fixed_dt_));
+        FrameTimes& times = frame_times_[layer_cache_ ? 1 : 0];
+        times.seconds += frame_time;
+        ++times.frames;
+        EndFrame();
     }
 }
 
+// Deterministic stand-in for a player: walks back and forth, jumping and attacking on a
+// fixed rhythm so every gameplay path gets exercised.
+static void ScriptedInput(int tick, InputState* input) {
+    const bool going_right = (tick / 480) % 2 == 0;
+    input->move_right = going_right;
+    input->move_left = !going_right;
+    input->jump_pressed = tick % 90 == 0;
+    input->punch_pressed = tick % 50 == 25;
+    input->heel_kick_pressed = tick % 90 == 30;
+}
+
+// Simulation-only loop for benchmarking: no window, no vsync, no rendering.
+// A replay runs for exactly its recorded length.
+void Game::RunHeadless() {
+    const bool replaying = !options_.replay_path.empty();
+    const int ticks = replaying ? static_cast<int>(replay_.TickCount()) : options_.headless_ticks;
+    const double freq = static_cast<double>(SDL_GetPerformanceFrequency());
+    const Uint64 start = SDL_GetPerformanceCounter();
+
+    for (int tick = 0; tick < ticks; ++tick) {
+        if (!replaying) {
+            ScriptedInput(tick, &input_);
+        }
+        PROFILE_SCOPE("Update");
+        BeginFrame();
+        if (options_.check_snapshot && tick == ticks / 2) {
+            frame_may_allocate_ = true;
+            SaveSnapshot(&quick_save_);
+        }
+        Step();
+        EndFrame();
+    }
+
+    const double seconds = static_cast<double>(SDL_GetPerformanceCounter() - start) / freq;
+    const double ticks_per_second = seconds > 0.0 ? ticks / seconds : 0.0;
+    const double ns_per_tick = ticks > 0 ? (seconds * 1e9) / ticks : 0.0;
+    std::cout << "headless: " << ticks << " ticks at " << options_.tick_rate << " Hz in " << seconds << " s, "
+              << ticks_per_second << " ticks/s, " << ns_per_tick << " ns/tick\n";
+    if (options_.check_snapshot) {
+        CheckSnapshot(ticks);
+    }
+}
+
+void Game::CheckSnapshot(int ticks) {
+    const std::uint64_t expected = StateChecksum();
+    const std::string path = !options_.snapshot_path.empty()
+                                 ? options_.snapshot_path
+                                 : (fs::temp_directory_path() / "angry_panda_check.apss").string();
+    GameSnapshot loaded;
+    if (!SaveSnapshotFile(path, quick_save_) || !LoadSnapshotFile(path, &loaded)) {
+        snapshot_check_failed_ = true;
+        return;
+    }
+    if (loaded.bytes != quick_save_.bytes || !RestoreSnapshot(loaded) || StateChecksum() != loaded.checksum) {
+        std::cerr << "snapshot: FAILED, tick " << loaded.tick << " did not come back from " << path << "\n";
+        snapshot_check_failed_ = true;
+        return;
+    }
+
+    // The file round trip above is the slow part; these are the in-memory calls a
+    // benchmark loop or a save state would make.
+    constexpr int kTimedCalls = 200;
+    const double freq = static_cast<double>(SDL_GetPerformanceFrequency());
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < kTimedCalls; ++i) {
+        SaveSnapshot(&quick_save_);
+    }
+    const double save_us = static_cast<double>(SDL_GetPerformanceCounter() - start) / freq * 1e6 / kTimedCalls;
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < kTimedCalls; ++i) {
+        RestoreSnapshot(quick_save_);
+    }
+    const double restore_us = static_cast<double>(SDL_GetPerformanceCounter() - start) / freq * 1e6 / kTimedCalls;
+
+    for (int tick = static_cast<int>(tick_); tick < ticks; ++tick) {
+        ScriptedInput(tick, &input_);
+        BeginFrame();
+        Step();
+        EndFrame();
+    }
+    const std::uint64_t actual = StateChecksum();
+    std::cout << "snapshot: " << quick_save_.bytes.size() << " bytes at tick " << loaded.tick << ", save "
+              << save_us << " us, restore " << restore_us << " us\n";
+    if (actual != expected) {
+        std::cerr << "snapshot: DIVERGED, the run from the restored state ends at 0x" << std::hex << actual
+                  << " instead of 0x" << expected << std::dec << "\n";
+        snapshot_check_failed_ = true;
+        return;
+    }
+    std::cout << "snapshot: restored run matches, checksum 0x" << std::hex << actual << std::dec << "\n";
+}
+
+void Game::BeginFrame() {
+    frame_arena_.Reset();
+    frame_may_allocate_ = false;
+    frame_start_allocations_ = alloc_counter::ThreadAllocations();
+}
+
+// ALLOC_CHECK builds only (see alloc_counter.hpp): an allocation here is a regression, so it
+// stops the game on the frame that made it rather than showing up later as a spike.
+void Game::EndFrame() {
+    ++frame_index_;
+    const std::uint64_t allocations = alloc_counter::ThreadAllocations() - frame_start_allocations_;
+    if (allocations == 0 || frame_may_allocate_ || frame_index_ <= kAllocationWarmupFrames) {
+        return;
+    }
+    std::cerr << "alloc: steady-state frame " << frame_index_ << " made " << allocations
+              << " heap allocation(s)\n";
+    std::abort();
+}
+
 // Event handling
 void Game::HandleEvents() {
     SDL_Event e;
-    input_.ClearFrame();
 
     while (SDL_PollEvent(&e)) {
         if (e.type == SDL_QUIT) {
             running_ = false;
         } else if (e.type == SDL_KEYDOWN && !e.key.repeat) {
+            if (e.key.keysym.sym == SDLK_F9 && profiler::Enabled()) {
+                WriteProfile();
+            } else if (e.key.keysym.sym == SDLK_F7) {
+                ToggleLayerCache();
+            } else if (e.key.keysym.sym == SDLK_F5) {
+                QuickSave();
+            } else if (e.key.keysym.sym == SDLK_F8) {
+                QuickLoad();
+            }
             input_.OnKeyDown(e.key.keysym.sym);
         } else if (e.type == SDL_KEYUP) {
             input_.OnKeyUp(e.key.keysym.sym);
+        } else if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET ||
+                   (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)) {
+            // Target contents are lost on a reset, and a resize changes how they scale.
+            backdrop_.Invalidate();
+            back_scenery_.Invalidate();
+            front_scenery_.Invalidate();
         }
     }
 }
 
+void Game::Step() {
+    if (!options_.replay_path.empty()) {
+        input_ = replay_.Input(tick_);
+    }
+    if (!options_.record_path.empty()) {
+        frame_may_allocate_ |= recorder_.Full();
+        recorder_.Record(tick_, input_);
+    }
+    Update(static_cast<float>(fixed_dt_));
+    // Presses stay latched until a tick has consumed them.
+    input_.ClearFrame();
+    ++tick_;
+}
+
 // Update player and game state
 void Game::Update(float dt) {
+    prev_camera_x_ = camera_x_;
+    StorePreviousTransforms(&registry_);
+
     player_.Update(dt, input_);
-    player_.CheckPlatformCollisions(platforms_);
+    player_.CheckPlatformCollisions(branch_grid_, &ground_grid_);
 
     const SDL_Rect player_rect = player_.GetBodyRect();
     const SDL_Rect attack_rect = player_.GetAttackRect();
 
-    for (SquirrelEnemy& squirrel : squirrels_) {
-        squirrel.Update(dt, player_rect);
+    squirrel_lod_.view_left = camera_x_;
+    squirrel_lod_.view_width = static_cast<float>(kWindowWidth);
+    UpdateSquirrels(&registry_, dt, player_rect, &acorns_, &jobs_, &squirrel_lod_);
+    AdvanceAnimations(&registry_, animations_, dt);
+    acorns_.Update(dt, &jobs_);
+    ResolveCollisions(player_rect, attack_rect, player_.GetMotion());
+
+    camera_x_ = player_.GetX() - 480;
+    StreamLevel();
+}
 
-        if (attack_rect.w > 0 && attack_rect.h > 0) {
-            squirrel.TryTakeHit(attack_rect);
+void Game::ResolveCollisions(const SDL_Rect& player_rect, const SDL_Rect& attack_rect, SDL_FPoint player_motion) {
+    // The player's box covers its whole move this tick, the acorns' boxes their whole
+    // paths, so every swept hit CheckHitPlayer can find is among the pairs.
+    const SDL_FRect player_start{static_cast<float>(player_rect.x) - player_motion.x,
+                                 static_cast<float>(player_rect.y) - player_motion.y,
+                                 static_cast<float>(player_rect.w), static_cast<float>(player_rect.h)};
+    broadphase_.Begin();
+    broadphase_.Add(BroadphaseLayer::kPlayerBody, 0, ToFRect(SweptBounds(player_start, player_motion)));
+    if (attack_rect.w > 0 && attack_rect.h > 0) {
+        broadphase_.Add(BroadphaseLayer::kPlayerAttack, 0, ToFRect(attack_rect));
+    }
+    AddSquirrelColliders(registry_, &broadphase_);
+    acorns_.AddColliders(&broadphase_);
+    broadphase_.FindPairs();
+
+    if (options_.check_broadphase) {
+        frame_may_allocate_ = true;
+        if (!broadphase_.MatchesBruteForce()) {
+            std::cerr << "broadphase: tick " << tick_ << " pairs differ from the brute-force pass ("
+                      << broadphase_.Pairs().size() << " found over " << broadphase_.ProxyCount() << " boxes)\n";
+            std::abort();
         }
+    }
 
-        float knockback_x = 0.0f;
-        if (squirrel.CheckProjectileHitPlayer(player_rect, &knockback_x)) {
-            player_.ApplyKnockback(knockback_x, -220.0f);
+    // Pairs come in sweep order; hits are applied in an order that does not depend on it.
+    ArenaArray<std::uint32_t> acorn_candidates = frame_arena_.MakeArray<std::uint32_t>(broadphase_.Pairs().size());
+    int squirrels_hit = 0;
+    for (const BroadphasePair& pair : broadphase_.Pairs()) {
+        const BroadphaseProxy& a = broadphase_.Proxy(pair.a);
+        const BroadphaseProxy& b = broadphase_.Proxy(pair.b);
+        if (a.layer == BroadphaseLayer::kPlayerAttack && b.layer == BroadphaseLayer::kEnemyBody) {
+            squirrels_hit += HitSquirrel(&registry_, b.key) ? 1 : 0;
+        } else if (a.layer == BroadphaseLayer::kPlayerBody && b.layer == BroadphaseLayer::kProjectile) {
+            acorn_candidates.push_back(b.key);
         }
     }
 
-    camera_x_ = player_.GetX() - 480;
+    if (squirrels_hit > 0) {
+        PlaySound(punch_sound_, player_.GetX());
+    }
+    float knockback_x = 0.0f;
+    if (acorns_.CheckHitPlayer(acorn_candidates.data(), static_cast<int>(acorn_candidates.size()), player_rect,
+                               player_motion, &knockback_x)) {
+        player_.ApplyKnockback(knockback_x, -220.0f);
+        PlaySound(hurt_sound_, player_.GetX());
+    }
 }
-// Render everything
-void Game::Render() {
+
+void Game::StreamLevel() {
+    level_.Update(camera_x_, kWindowWidth, &activated_chunks_, &deactivated_chunks_);
+    if (activated_chunks_.empty() && deactivated_chunks_.empty()) {
+        return;
+    }
+    frame_may_allocate_ = true;
+
+    // Backwards, because Destroy swap-removes from the store being walked.
+    for (int i = static_cast<int>(registry_.chunk_members.Size()) - 1; i >= 0; --i) {
+        const int chunk = registry_.chunk_members.Data()[i].chunk;
+        if (std::find(deactivated_chunks_.begin(), deactivated_chunks_.end(), chunk) != deactivated_chunks_.end()) {
+            registry_.Destroy(registry_.chunk_members.Entities()[i]);
+        }
+    }
+    for (const LevelChunk* chunk : activated_chunks_) {
+        for (const SDL_FPoint& spawn : chunk->squirrels) {
+            const Entity squirrel = SpawnSquirrel(&registry_, spawn.x, spawn.y, squirrel_clip_);
+            registry_.chunk_members.Add(squirrel, ChunkMember{chunk->index});
+        }
+    }
+    IndexSquirrels(registry_, &squirrel_lod_);
+
+    RebuildLevelGrids();
+    // Acorns flying out of the resident level would never hit anything again.
+    acorns_.SetBounds(level_.ActiveLeft(), level_.ActiveRight());
+}
+
+// A handful of chunks is resident at a time, so rebuilding from scratch is cheap and only
+// happens when one comes or goes.
+void Game::RebuildLevelGrids() {
+    auto build = [this](StaticGrid* grid, std::initializer_list<std::vector<SDL_Rect> LevelChunk::*> items) {
+        std::size_t count = 0;
+        for (std::vector<SDL_Rect> LevelChunk::*item : items) {
+            for (const std::unique_ptr<LevelChunk>& chunk : level_.Active()) {
+                count += ((*chunk).*item).size();
+            }
+        }
+        ArenaArray<SDL_Rect> rects = frame_arena_.MakeArray<SDL_Rect>(count);
+        for (std::vector<SDL_Rect> LevelChunk::*item : items) {
+            for (const std::unique_ptr<LevelChunk>& chunk : level_.Active()) {
+                for (const SDL_Rect& rect : (*chunk).*item) {
+                    rects.push_back(rect);
+                }
+            }
+        }
+        grid->Build(rects.data(), rects.size());
+    };
+    build(&ground_grid_, {&LevelChunk::grounds});
+    build(&branch_grid_, {&LevelChunk::branches});
+    build(&tree_grid_, {&LevelChunk::trees});
+    build(&bush_grid_, {&LevelChunk::bushes});
+    back_scenery_.Invalidate();
+    front_scenery_.Invalidate();
+}
+void Game::SetAudio(AudioManager* audio) {
+    audio_ = audio;
+    if (audio_) {
+        punch_sound_ = audio_->findSFX(soundId("punch"));
+        hurt_sound_ = audio_->findSFX(soundId("hurt"));
+    }
+}
+
+void Game::PlaySound(SoundHandle sound, float world_x) {
+    if (!audio_) {
+        return;
+    }
+    const float screen_x = world_x - camera_x_;
+    const float pan = (screen_x - kWindowWidth * 0.5f) / (kWindowWidth * 0.5f);
+    audio_->playSFX(sound, 1.0f, pan);
+}
+
+// Render everything, blending alpha of the way from the previous tick to the current one
+void Game::Render(float alpha) {
+    PROFILE_SCOPE("Render");
+    const float camera_x = prev_camera_x_ + (camera_x_ - prev_camera_x_) * alpha;
+    // World-space view; screen x is world x minus view.x.
+    const SDL_Rect view{static_cast<int>(camera_x), 0, kWindowWidth, kWindowHeight};
+    if (layer_cache_) {
+        PrepareLayers(view);
+    }
+
     // Clear screen
     SDL_SetRenderDrawColor(renderer_, 25, 25, 30, 255);
     SDL_RenderClear(renderer_);
 
-    // Draw background
-    if(!background_texture_.Empty())
-    {
-        SDL_Rect bgRect;
-        bgRect.x = 0;
-        bgRect.y = 0;
-        bgRect.w = kWindowWidth;
-        bgRect.h = kWindowHeight;
-        SDL_RenderCopy(renderer_, background_texture_.frames[0], NULL, &bgRect);
-    }
-
-    // Draw trees
-    if(!tree_texture_.Empty())
-    {
-        SDL_Rect treeRect;
-        treeRect.x = 150 - static_cast<int>(camera_x_); // left/right
-        treeRect.y = 0;
-        treeRect.w = 220; // wider/narrower
-        treeRect.h = kWindowHeight;
-        SDL_RenderCopy(renderer_, tree_texture_.frames[0], NULL, &treeRect);
-    }
-    if(!tree_texture_.Empty())
-    {
-        SDL_Rect treeRect;
-        treeRect.x = 450 - static_cast<int>(camera_x_); // left/right
-        treeRect.y = 0;
-        treeRect.w = 225; // wider/narrower
-        treeRect.h = kWindowHeight;
-        SDL_RenderCopy(renderer_, tree_texture_.frames[0], NULL, &treeRect);
-    }
-
-    // Draw ground
-    SDL_SetRenderDrawColor(renderer_, 34, 139, 34, 255);
-    SDL_Rect ground{0, kWindowHeight - 40, kWindowWidth, 40};
-    SDL_RenderFillRect(renderer_, &ground);
-
-    //Draw platforms
-    for(const auto& platform : platforms_)
-    {
-        if(platform.rect.w > 1000) continue;
-        SDL_Rect screenRect;
-        screenRect.w = platform.rect.w;
-        screenRect.h = platform.rect.h;
-        screenRect.x = platform.rect.x - static_cast<int>(camera_x_);
-        screenRect.y = platform.rect.y;
-        if(!platform_textures_.Empty())
-        {
-            SDL_RenderCopy(renderer_, platform_textures_.frames[0], NULL, &screenRect);
-        }
-    }
+    // Every sprite below goes through one batch; layering follows submission order.
+    sprite_batch_.Begin(renderer_);
+    cull_stats_ = CullStats{};
 
-    for (const SquirrelEnemy& squirrel : squirrels_) {
-        squirrel.Render(renderer_, camera_x_);
+    // Background, trees, ground and branches
+    if (layer_cache_) {
+        backdrop_.Draw(&sprite_batch_, SDL_Rect{0, 0, kWindowWidth, kWindowHeight});
+        back_scenery_.Draw(&sprite_batch_, view);
+    } else {
+        DrawBackground();
+        DrawBackScenery(view);
     }
 
+    const int visible_squirrels = RenderSquirrels(registry_, animations_, &sprite_batch_, view, camera_x);
+    cull_stats_.visible += visible_squirrels;
+    cull_stats_.culled += static_cast<int>(registry_.shooters.Size()) - visible_squirrels;
+    const int visible_acorns = acorns_.Render(&sprite_batch_, view, camera_x, alpha);
+    cull_stats_.visible += visible_acorns;
+    cull_stats_.culled += acorns_.Count() - visible_acorns;
+
     // Draw player
-    player_.Render(renderer_, camera_x_);
+    player_.Render(&sprite_batch_, camera_x, alpha);
 
-    // Draw bushes NEW
-    if(!bush_texture_.Empty())
-    {
-        for(int i = 0; i < 20; i++) // number of bushes
-        {
-            int xPos = i * 300; // spacing
-
-            SDL_Rect bushRect;
-            bushRect.x = xPos - static_cast<int>(camera_x_);
-            bushRect.y = kWindowHeight - 100; // height
-            bushRect.w = 70; // size
-            bushRect.h = 80;
-            SDL_RenderCopy(renderer_, bush_texture_.frames[0], NULL, &bushRect);
-        }
+    // Draw bushes
+    if (layer_cache_) {
+        front_scenery_.Draw(&sprite_batch_, view);
+    } else {
+        DrawScenery(bush_grid_, bush_texture_, view);
     }
 
-    // Present final frame
+    sprite_batch_.End();
+    if (options_.render_stats) {
+        ReportRenderStats();
+    }
+
+    // Present final frame; with vsync this is where the frame waits for the display.
+    PROFILE_SCOPE("Present");
     SDL_RenderPresent(renderer_);
 }
+
+void Game::PrepareLayers(const SDL_Rect& view) {
+    PROFILE_SCOPE("PrepareLayers");
+    // The backdrop is screen space: its only tile is the one at the origin.
+    backdrop_.Prepare(SDL_Rect{0, 0, kWindowWidth, kWindowHeight}, &sprite_batch_,
+                      [this](const SDL_Rect&) { DrawBackground(); });
+    back_scenery_.Prepare(view, &sprite_batch_, [this](const SDL_Rect& area) { DrawBackScenery(area); });
+    front_scenery_.Prepare(view, &sprite_batch_, [this](const SDL_Rect& area) {
+        DrawScenery(bush_grid_, bush_texture_, area);
+    });
+}
+
+void Game::DrawBackground() {
+    if (HasFrames(background_texture_)) {
+        sprite_batch_.Draw(background_texture_->frames[0], SDL_Rect{0, 0, kWindowWidth, kWindowHeight});
+    }
+}
+
+void Game::DrawBackScenery(const SDL_Rect& view) {
+    DrawScenery(tree_grid_, tree_texture_, view);
+
+    // Ground is drawn where the level has it, so a gap shows as a pit; only branches get a
+    // sprite.
+    ground_grid_.Query(view, [this, &view](int index) {
+        SDL_Rect rect = ground_grid_.Rect(index);
+        rect.x -= view.x;
+        sprite_batch_.FillRect(rect, SDL_Color{34, 139, 34, 255});
+    });
+
+    DrawScenery(branch_grid_, platform_textures_, view);
+}
+
+void Game::ToggleLayerCache() {
+    frame_may_allocate_ = true;
+    if (!layers_available_) {
+        std::cout << "layer cache: render targets unavailable\n";
+        return;
+    }
+    layer_cache_ = !layer_cache_;
+    std::cout << "layer cache: " << (layer_cache_ ? "on" : "off") << "\n";
+}
+
+// Draws the sprites of scenery that intersect view, in index order so layering is stable.
+void Game::DrawScenery(const StaticGrid& scenery, const TextureHandle& texture, const SDL_Rect& view) {
+    if (!HasFrames(texture)) {
+        return;
+    }
+
+    ArenaArray<int> visible = frame_arena_.MakeArray<int>(scenery.Size());
+    scenery.Query(view, [&visible](int index) { visible.push_back(index); });
+    std::sort(visible.begin(), visible.end());
+    for (int index : visible) {
+        SDL_Rect rect = scenery.Rect(index);
+        rect.x -= view.x;
+        sprite_batch_.Draw(texture->frames[0], rect);
+    }
+
+    cull_stats_.visible += static_cast<int>(visible.size());
+    cull_stats_.culled += static_cast<int>(scenery.Size() - visible.size());
+}
+
+void Game::WriteProfile() {
+    frame_may_allocate_ = true;
+    const profiler::FrameSummary frames = profiler::SummarizeFrames();
+    std::cout << "profile: last " << frames.frames << " frames p50 " << frames.p50_ms << " ms, p95 "
+              << frames.p95_ms << " ms, p99 " << frames.p99_ms << " ms\n";
+    if (profiler::WriteChromeTrace(options_.trace_path)) {
+        std::cout << "profile: wrote trace to " << options_.trace_path << "\n";
+    } else {
+        std::cerr << "profile: cannot write " << options_.trace_path << "\n";
+    }
+}
+
+// Prints once a second how many sprites were drawn and what they cost in draw calls.
+void Game::ReportRenderStats() {
+    const RenderStats& stats = sprite_batch_.Stats();
+    stats_frames_ += 1;
+    stats_sprites_ += stats.sprites;
+    stats_draw_calls_ += stats.draw_calls;
+    stats_texture_switches_ += stats.texture_switches;
+    stats_visible_ += cull_stats_.visible;
+    stats_culled_ += cull_stats_.culled;
+
+    const Uint32 now = SDL_GetTicks();
+    if (now - stats_last_report_ < 1000) {
+        return;
+    }
+    frame_may_allocate_ = true;
+
+    std::cout << "render: " << stats_frames_ << " frames, per frame "
+              << stats_sprites_ / stats_frames_ << " sprites, "
+              << stats_draw_calls_ / stats_frames_ << " draw calls, "
+              << stats_texture_switches_ / stats_frames_ << " texture switches, "
+              << stats_visible_ / stats_frames_ << " visible / "
+              << stats_culled_ / stats_frames_ << " culled objects\n";
+    stats_last_report_ = now;
+    stats_frames_ = 0;
+    stats_sprites_ = 0;
+    stats_draw_calls_ = 0;
+    stats_texture_switches_ = 0;
+    stats_visible_ = 0;
+    stats_culled_ = 0;
+}
+
+std::uint64_t Game::StateChecksum() const {
+    StateHasher hasher;
+    hasher.Add(tick_);
+    hasher.Add(camera_x_);
+    HashState(registry_, &hasher);
+    player_.HashState(&hasher);
+    hasher.Add(acorns_.StateHash());
+    return hasher.Value();
+}
+
+void Game::SaveSnapshot(GameSnapshot* snapshot) const {
+    snapshot->tick = tick_;
+    snapshot->checksum = StateChecksum();
+    SnapshotWriter out(&snapshot->bytes);
+    out.Write(tick_);
+    out.Write(camera_x_);
+    out.Write(prev_camera_x_);
+    out.Write(input_.Pack());
+    out.Write(player_.SaveState());
+    out.Write(squirrel_lod_.far_cursor);
+    out.Write(static_cast<std::uint32_t>(level_.Active().size()));
+    for (const std::unique_ptr<LevelChunk>& chunk : level_.Active()) {
+        out.Write(chunk->index);
+    }
+    registry_.Save(&out);
+    acorns_.Save(&out);
+}
+
+bool Game::RestoreSnapshot(const GameSnapshot& snapshot) {
+    SnapshotReader in(snapshot.bytes.data(), snapshot.bytes.size());
+    std::uint8_t input_bits = 0;
+    PlayerState player{};
+    if (!in.Read(&tick_) || !in.Read(&camera_x_) || !in.Read(&prev_camera_x_) || !in.Read(&input_bits) ||
+        !in.Read(&player) || !in.Read(&squirrel_lod_.far_cursor) ||
+        !in.ReadArray(&snapshot_chunks_, static_cast<std::size_t>(level_.ChunkCount())) ||
+        !registry_.Restore(&in) || !acorns_.Restore(&in) || !in.Done() ||
+        !level_.SetActive(snapshot_chunks_, &activated_chunks_, &deactivated_chunks_)) {
+        std::cerr << "snapshot: tick " << snapshot.tick << " is malformed and was not fully restored\n";
+        return false;
+    }
+    input_ = InputState::Unpack(input_bits);
+    player_.RestoreState(player);
+
+    // The restored registry already holds what the chunks spawned; only the geometry built
+    // from them has to follow.
+    if (!activated_chunks_.empty() || !deactivated_chunks_.empty()) {
+        frame_may_allocate_ = true;
+        RebuildLevelGrids();
+    }
+    acorns_.SetBounds(level_.ActiveLeft(), level_.ActiveRight());
+    IndexSquirrels(registry_, &squirrel_lod_);
+    return true;
+}
+
+void Game::QuickSave() {
+    if (!options_.record_path.empty() || !options_.replay_path.empty()) {
+        std::cerr << "snapshot: not saved while recording or replaying\n";
+        return;
+    }
+    frame_may_allocate_ = true;
+    SaveSnapshot(&quick_save_);
+    if (!options_.snapshot_path.empty() && SaveSnapshotFile(options_.snapshot_path, quick_save_)) {
+        std::cout << "snapshot: tick " << quick_save_.tick << " saved to " << options_.snapshot_path << "\n";
+    }
+}
+
+void Game::QuickLoad() {
+    if (!options_.record_path.empty() || !options_.replay_path.empty()) {
+        std::cerr << "snapshot: not restored while recording or replaying\n";
+        return;
+    }
+    frame_may_allocate_ = true;
+    if (quick_save_.bytes.empty() &&
+        (options_.snapshot_path.empty() || !LoadSnapshotFile(options_.snapshot_path, &quick_save_))) {
+        return;
+    }
+    if (RestoreSnapshot(quick_save_)) {
+        std::cout << "snapshot: back at tick " << quick_save_.tick << "\n";
+    }
+}
+
+// Saves the recording and checks the replay, both against the state after the last tick.
+void Game::FinishInputSession() {
+    if (options_.record_path.empty() && options_.replay_path.empty()) {
+        return;
+    }
+
+    const std::uint64_t checksum = StateChecksum();
+    std::cout << "input: " << tick_ << " ticks, state checksum 0x" << std::hex << checksum << std::dec << "\n";
+
+    if (!options_.replay_path.empty()) {
+        if (tick_ != replay_.TickCount()) {
+            std::cerr << "replay: stopped after " << tick_ << " of " << replay_.TickCount()
+                      << " ticks, checksum not comparable\n";
+            replay_diverged_ = true;
+        } else if (checksum != replay_.ExpectedChecksum()) {
+            std::cerr << "replay: DIVERGED, recording expects 0x" << std::hex << replay_.ExpectedChecksum()
+                      << std::dec << "\n";
+            replay_diverged_ = true;
+        } else {
+            std::cout << "replay: matches recording\n";
+        }
+    }
+
+    if (!options_.record_path.empty() &&
+        recorder_.Save(options_.record_path, tick_, static_cast<std::uint32_t>(options_.tick_rate),
+                       static_cast<std::uint32_t>(options_.ai_budget), checksum)) {
+        std::cout << "input: recorded " << recorder_.ChangeCount() << " input changes to "
+                  << options_.record_path << "\n";
+    }
+}
+
 void Game::Shutdown() {
-    DestroyTextureSet(idle_textures_);
-    DestroyTextureSet(walk_textures_);
-    DestroyTextureSet(jump_textures_);
-    DestroyTextureSet(punch_textures_);
-    DestroyTextureSet(heel_kick_textures_);
-    DestroyTextureSet(player_texture_);
-    DestroyTextureSet(platform_textures_);
-    DestroyTextureSet(ground_texture_);
-    DestroyTextureSet(background_texture_);
-    DestroyTextureSet(tree_texture_);
-    DestroyTextureSet(bush_texture_);
-    DestroyTextureSet(squirrel_textures_);
-    DestroyTextureSet(acorn_textures_);
+    FinishInputSession();
+    if (profiler::Enabled()) {
+        WriteProfile();
+    }
+    std::cout << "frame arena: " << frame_arena_.HighWater() << " of " << frame_arena_.Capacity()
+              << " bytes at most, " << frame_arena_.Overflows() << " allocation(s) overflowed\n";
+
+    if (broadphase_.Sweeps() > 0) {
+        std::cout << "broadphase: " << static_cast<double>(broadphase_.TotalPairs()) / broadphase_.Sweeps()
+                  << " candidate pairs per tick on average, " << broadphase_.PeakPairs() << " at most"
+                  << (options_.check_broadphase ? ", all matched the brute-force pass" : "") << "\n";
+    }
+    if (squirrel_lod_.ticks > 0) {
+        const SquirrelLodStats& ai = squirrel_lod_.total;
+        const double ticks = static_cast<double>(squirrel_lod_.ticks);
+        std::cout << "squirrel ai per tick on average: " << ai.near_ticked / ticks << " near, "
+                  << ai.far_ticked / ticks << " far ticked, " << ai.far_waiting / ticks << " far waiting, "
+                  << ai.dormant / ticks << " dormant\n";
+    }
+    std::cout << "level: " << level_.Loads() << " chunk loads, " << level_.Stalls()
+              << " waited for\n";
+    level_.Close();
+
+    // F7 during a session gives both lines for the same scenes.
+    for (int on = 0; on < 2; ++on) {
+        const FrameTimes& times = frame_times_[on];
+        if (times.frames > 0) {
+            std::cout << "frame time with layer cache " << (on ? "on" : "off") << ": "
+                      << times.seconds * 1000.0 / times.frames << " ms average over " << times.frames
+                      << " frames\n";
+        }
+    }
+    backdrop_.Destroy();
+    back_scenery_.Destroy();
+    front_scenery_.Destroy();
+
+    // Drop every gameplay handle first so the cache can report anything still held.
+    acorns_.SetTextures(nullptr);
+    player_ = Player{};
+    registry_.Clear();
+    animations_.Clear();
+    jobs_.Shutdown();
+    background_texture_.reset();
+    tree_texture_.reset();
+    bush_texture_.reset();
+    platform_textures_.reset();
+    assets_.Shutdown();
 
     // Destroy renderer and window
     if (renderer_) {
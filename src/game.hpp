@@ -1,46 +1,198 @@
 #pragma once
 #include <SDL.h>
+#include <array>
+#include <string>
 #include <vector>
 #include "input.hpp"
+#include "input_replay.hpp"
+#include "job_system.hpp"
+#include "level_stream.hpp"
 #include "player.hpp"
-#include "platform.hpp"
+#include "asset_cache.hpp"
+#include "audioManager.hpp"
+#include "broadphase.hpp"
 #include "enemy.hpp"
+#include "frame_arena.hpp"
+#include "projectiles.hpp"
+#include "registry.hpp"
+#include "snapshot.hpp"
+#include "spatial_grid.hpp"
+#include "sprite_batch.hpp"
+#include "static_layer.hpp"
 #include "texture_set.hpp"
 
+struct GameOptions {
+    bool headless = false;
+    int headless_ticks = 100000;
+    // Simulation ticks per second. Collisions are swept, so lower rates stay correct and
+    // only cost precision in the motion itself. A replay uses the rate it was recorded at.
+    int tick_rate = 120;
+    bool render_stats = false;
+    // Static scenery is pre-composited into render targets; F7 toggles this while running.
+    bool layer_cache = true;
+    // SDL's software renderer without vsync, so frame times show what drawing costs.
+    bool software_renderer = false;
+    // Runs every parallel system inline on the main thread, for comparison.
+    bool single_thread = false;
+    // Checks the broadphase's pairs against a brute-force pass every tick; aborts on a
+    // mismatch.
+    bool check_broadphase = false;
+    // Most squirrels away from the view whose AI runs in one tick (see SquirrelLod); the
+    // rest wait for a later slice. A replay uses the budget it was recorded with.
+    int ai_budget = 64;
+    // Non-empty enables the profiler; the trace is written here on F9 and at exit.
+    std::string trace_path{};
+    // Non-empty writes every tick's input here at exit, plus the final state checksum.
+    std::string record_path{};
+    // Non-empty replays this recording instead of live or scripted input, then checks the
+    // final state against the checksum stored in it.
+    std::string replay_path{};
+    // Non-empty makes F5 also write the quick save here, and F8 read it back from here when
+    // there is none in memory.
+    std::string snapshot_path{};
+    // Headless only: saves a snapshot halfway, finishes the run, restores it (through a
+    // file), runs the second half again and checks that both runs end in the same state.
+    bool check_snapshot = false;
+};
+
+// World objects considered by the last Render call, split by whether they reached the batch.
+struct CullStats {
+    int visible = 0;
+    int culled = 0;
+};
+
 class Game {
 public:
-    bool Init();
+    bool Init(const GameOptions& options = {});
     void Run();
+    void RunHeadless();
     void Shutdown();
+    // Sound effects for gameplay events; null (the default, and headless) plays nothing.
+    void SetAudio(AudioManager* audio);
+
+    const CullStats& LastCullStats() const { return cull_stats_; }
+    // Hash of all simulation state; equal inputs from the same start must give equal hashes.
+    std::uint64_t StateChecksum() const;
+    bool ReplayDiverged() const { return replay_diverged_; }
+    bool SnapshotCheckFailed() const { return snapshot_check_failed_; }
+
+    // Copies the simulation state (registry, player, acorns, camera, input, resident chunks)
+    // into snapshot, reusing its storage.
+    void SaveSnapshot(GameSnapshot* snapshot) const;
+    // Puts the simulation back where snapshot was taken, rebuilding the level grids if the
+    // resident chunks differ. A snapshot this build saved, directly or through a file, always
+    // restores; anything else may fail part way and leave the state unspecified.
+    bool RestoreSnapshot(const GameSnapshot& snapshot);
 
 private:
+    // Brackets one frame (one tick when headless): resets the frame arena, then checks that
+    // a steady-state frame made no heap allocations.
+    void BeginFrame();
+    void EndFrame();
     void HandleEvents();
+    // One fixed tick: takes input from the replay if there is one, records it, updates.
+    void Step();
     void Update(float dt);
-    void Render();
+    // Follows the camera through the level: spawns what chunks coming into range hold,
+    // removes what the dropped ones held, and re-indexes the resident geometry.
+    void StreamLevel();
+    void RebuildLevelGrids();
+    // Pairs the attack with squirrels and the player with acorns in one broadphase pass,
+    // then applies the hits among those pairs.
+    void ResolveCollisions(const SDL_Rect& player_rect, const SDL_Rect& attack_rect, SDL_FPoint player_motion);
+    // Pans the effect by where world_x sits on screen.
+    void PlaySound(SoundHandle sound, float world_x);
+    bool ReplayFinished() const { return !options_.replay_path.empty() && tick_ >= replay_.TickCount(); }
+    void FinishInputSession();
+    // F5 and F8. Not while recording or replaying, whose input is tied to the tick count.
+    void QuickSave();
+    void QuickLoad();
+    // The second half of --check-snapshot, once RunHeadless has run every tick.
+    void CheckSnapshot(int ticks);
+    void Render(float alpha);
+    // Composites any layer tile the view needs that is not cached yet.
+    void PrepareLayers(const SDL_Rect& view);
+    void DrawBackground();
+    // Trees, the ground strip and branches: the static scenery behind the characters.
+    void DrawBackScenery(const SDL_Rect& view);
+    void DrawScenery(const StaticGrid& scenery, const TextureHandle& texture, const SDL_Rect& view);
+    void ToggleLayerCache();
+    void ReportRenderStats();
+    void WriteProfile();
 
     SDL_Window* window_ = nullptr;
     SDL_Renderer* renderer_ = nullptr;
-    TextureSet player_texture_{};
-    TextureSet idle_textures_{};
-    TextureSet walk_textures_{};
-    TextureSet punch_textures_{};
-    TextureSet jump_textures_{};
-    TextureSet heel_kick_textures_{};
-    TextureSet platform_textures_{};
-    TextureSet ground_texture_{};
-    TextureSet background_texture_{};
-    TextureSet tree_texture_{};
-    TextureSet bush_texture_{};
-    TextureSet squirrel_textures_{};
-    TextureSet acorn_textures_{};
-    std::vector<Platform> platforms_;
-    std::vector<SquirrelEnemy> squirrels_;
-    
+    SpriteBatch sprite_batch_{};
+    AssetCache assets_{};
+    TextureHandle platform_textures_{};
+    TextureHandle background_texture_{};
+    TextureHandle tree_texture_{};
+    TextureHandle bush_texture_{};
+    LevelStreamer level_{};
+    std::vector<const LevelChunk*> activated_chunks_{};
+    std::vector<int> deactivated_chunks_{};
+    // Built from the active chunks only. Branches are one-way platforms; the ground
+    // strips are solid.
+    StaticGrid ground_grid_{};
+    StaticGrid branch_grid_{};
+    StaticGrid tree_grid_{};
+    StaticGrid bush_grid_{};
+    CullStats cull_stats_{};
+    // Render-target copies of the static layers, used while layer_cache_ is set.
+    StaticLayer backdrop_{};
+    StaticLayer back_scenery_{};
+    StaticLayer front_scenery_{};
+    bool layers_available_ = false;
+    bool layer_cache_ = false;
+    // Frame time totals with the layer cache off ([0]) and on ([1]), reported at exit.
+    struct FrameTimes {
+        double seconds = 0.0;
+        int frames = 0;
+    };
+    std::array<FrameTimes, 2> frame_times_{};
+    // Player and squirrels are entities here; acorns keep their own SoA pool.
+    Registry registry_{};
+    AnimationLibrary animations_{};
+    ClipId squirrel_clip_ = kNoClip;
+    AcornPool acorns_{};
+    SquirrelLod squirrel_lod_{};
+    Broadphase broadphase_{};
+    JobSystem jobs_{};
+    AudioManager* audio_ = nullptr;
+    SoundHandle punch_sound_{};
+    SoundHandle hurt_sound_{};
+
+    // Transient per-frame data (visible lists, grid rebuild input) comes from here.
+    FrameArena frame_arena_{};
+    std::uint64_t frame_index_ = 0;
+    std::uint64_t frame_start_allocations_ = 0;
+    // Set by the few things allowed to allocate in the frame loop (level streaming,
+    // writing a trace, printing stats); the frame is then not checked.
+    bool frame_may_allocate_ = false;
 
+    GameOptions options_{};
+    Uint32 stats_last_report_ = 0;
+    int stats_frames_ = 0;
+    int stats_sprites_ = 0;
+    int stats_draw_calls_ = 0;
+    int stats_texture_switches_ = 0;
+    int stats_visible_ = 0;
+    int stats_culled_ = 0;
     bool running_ = false;
 
     float camera_x_ = 0.0f;
+    float prev_camera_x_ = 0.0f;
 
     InputState input_{};
     Player player_{};
+
+    std::uint32_t tick_ = 0;
+    double fixed_dt_ = 0.0;  // seconds per tick
+    InputRecorder recorder_{};
+    InputReplay replay_{};
+    bool replay_diverged_ = false;
+
+    GameSnapshot quick_save_{};
+    std::vector<int> snapshot_chunks_{};  // RestoreSnapshot scratch
+    bool snapshot_check_failed_ = false;
 };
@@ -1,5 +1,6 @@
 #pragma once
 #include <SDL.h>
+#include <cstdint>
 
 struct InputState {
     bool move_left = false;
@@ -26,4 +27,20 @@ struct InputState {
         if (key == SDLK_a || key == SDLK_LEFT) move_left = false;
         if (key == SDLK_d || key == SDLK_RIGHT) move_right = false;
     }
+
+    // One bit per field, for input recordings.
+    std::uint8_t Pack() const {
+        return static_cast<std::uint8_t>((move_left ? 1 : 0) | (move_right ? 2 : 0) | (jump_pressed ? 4 : 0) |
+                                         (punch_pressed ? 8 : 0) | (heel_kick_pressed ? 16 : 0));
+    }
+
+    static InputState Unpack(std::uint8_t bits) {
+        InputState input;
+        input.move_left = (bits & 1) != 0;
+        input.move_right = (bits & 2) != 0;
+        input.jump_pressed = (bits & 4) != 0;
+        input.punch_pressed = (bits & 8) != 0;
+        input.heel_kick_pressed = (bits & 16) != 0;
+        return input;
+    }
 };
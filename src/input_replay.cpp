@@ -0,0 +1,125 @@
+#include "input_replay.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace {
+void WriteVarint(std::vector<std::uint8_t>* out, std::uint32_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<std::uint8_t>(value));
+}
+
+bool ReadVarint(const std::vector<std::uint8_t>& in, std::size_t* pos, std::uint32_t* value) {
+    std::uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*pos >= in.size()) {
+            return false;
+        }
+        const std::uint8_t byte = in[(*pos)++];
+        result |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+void InputRecorder::Record(std::uint32_t tick, const InputState& input) {
+    const std::uint8_t bits = input.Pack();
+    // Tick 0 starts from "nothing held", matching InputReplay's initial state.
+    const std::uint8_t previous = changes_.empty() ? 0 : changes_.back().bits;
+    if (bits != previous) {
+        changes_.push_back(InputChange{tick, bits});
+    }
+}
+
+bool InputRecorder::Save(const std::string& path, std::uint32_t tick_count, std::uint32_t tick_rate,
+                         std::uint32_t ai_budget, std::uint64_t checksum) const {
+    std::vector<std::uint8_t> stream;
+    stream.reserve(changes_.size() * 2);
+    std::uint32_t last_tick = 0;
+    for (const InputChange& change : changes_) {
+        WriteVarint(&stream, change.tick - last_tick);
+        stream.push_back(change.bits);
+        last_tick = change.tick;
+    }
+
+    ReplayHeader header{};
+    std::memcpy(header.magic, kReplayMagic, sizeof(header.magic));
+    header.version = kReplayVersion;
+    header.tick_count = tick_count;
+    header.change_count = static_cast<std::uint32_t>(changes_.size());
+    header.tick_rate = tick_rate;
+    header.ai_budget = ai_budget;
+    header.checksum = checksum;
+    header.stream_size = stream.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Cannot write input recording " << path << "\n";
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(stream.data()), static_cast<std::streamsize>(stream.size()));
+    return static_cast<bool>(out);
+}
+
+bool InputReplay::Load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot open input recording " << path << "\n";
+        return false;
+    }
+
+    ReplayHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, kReplayMagic, sizeof(header.magic)) != 0 ||
+        header.version != kReplayVersion || header.tick_rate == 0) {
+        std::cerr << "Input recording " << path << " has an unsupported or corrupt header\n";
+        return false;
+    }
+
+    std::vector<std::uint8_t> stream(static_cast<std::size_t>(header.stream_size));
+    in.read(reinterpret_cast<char*>(stream.data()), static_cast<std::streamsize>(stream.size()));
+    if (!in) {
+        std::cerr << "Input recording " << path << " is truncated\n";
+        return false;
+    }
+
+    std::vector<InputChange> changes;
+    changes.reserve(header.change_count);
+    std::size_t pos = 0;
+    std::uint32_t tick = 0;
+    for (std::uint32_t i = 0; i < header.change_count; ++i) {
+        std::uint32_t delta = 0;
+        if (!ReadVarint(stream, &pos, &delta) || pos >= stream.size()) {
+            std::cerr << "Input recording " << path << " is truncated\n";
+            return false;
+        }
+        tick += delta;
+        changes.push_back(InputChange{tick, stream[pos++]});
+    }
+
+    changes_ = std::move(changes);
+    next_ = 0;
+    current_ = 0;
+    tick_count_ = header.tick_count;
+    tick_rate_ = header.tick_rate;
+    ai_budget_ = header.ai_budget;
+    checksum_ = header.checksum;
+    return true;
+}
+
+InputState InputReplay::Input(std::uint32_t tick) {
+    while (next_ < changes_.size() && changes_[next_].tick <= tick) {
+        current_ = changes_[next_].bits;
+        ++next_;
+    }
+    return InputState::Unpack(current_);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "input.hpp"
+
+// On-disk layout of an input recording:
+//
+//   ReplayHeader
+//   change stream   per change: ticks since the previous change as a LEB128 varint,
+//                   then the InputState::Pack() byte that holds from that tick on
+//
+// Only ticks whose input differs from the tick before are stored, so holding a direction
+// for a few seconds costs two bytes. The checksum is the game state after the last tick,
+// which only matches when the replay runs at the recorded tick rate and AI budget.
+constexpr char kReplayMagic[4] = {'A', 'P', 'I', 'R'};
+constexpr std::uint32_t kReplayVersion = 3;
+
+struct ReplayHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t tick_count;
+    std::uint32_t change_count;
+    std::uint32_t tick_rate;  // ticks per second
+    std::uint32_t ai_budget;  // GameOptions::ai_budget
+    std::uint64_t checksum;
+    std::uint64_t stream_size;
+};
+
+struct InputChange {
+    std::uint32_t tick;
+    std::uint8_t bits;
+};
+
+// Collects the input fed to each tick; Save writes the file once the session ends.
+class InputRecorder {
+public:
+    // Ticks must be recorded in order, starting at 0, one call per tick.
+    void Record(std::uint32_t tick, const InputState& input);
+    bool Save(const std::string& path, std::uint32_t tick_count, std::uint32_t tick_rate,
+              std::uint32_t ai_budget, std::uint64_t checksum) const;
+
+    std::size_t ChangeCount() const { return changes_.size(); }
+    // Room for changes up front; the next Record past it allocates.
+    void Reserve(std::size_t changes) { changes_.reserve(changes); }
+    bool Full() const { return changes_.size() == changes_.capacity(); }
+
+private:
+    std::vector<InputChange> changes_{};
+};
+
+// Plays a recording back tick by tick in place of polling SDL.
+class InputReplay {
+public:
+    bool Load(const std::string& path);
+
+    // Input for tick; ticks must be asked for in increasing order.
+    InputState Input(std::uint32_t tick);
+
+    std::uint32_t TickCount() const { return tick_count_; }
+    std::uint32_t TickRate() const { return tick_rate_; }
+    std::uint32_t AiBudget() const { return ai_budget_; }
+    std::uint64_t ExpectedChecksum() const { return checksum_; }
+
+private:
+    std::vector<InputChange> changes_{};
+    std::size_t next_ = 0;
+    std::uint8_t current_ = 0;
+    std::uint32_t tick_count_ = 0;
+    std::uint32_t tick_rate_ = 0;
+    std::uint32_t ai_budget_ = 0;
+    std::uint64_t checksum_ = 0;
+};
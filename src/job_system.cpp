@@ -0,0 +1,124 @@
+#include "job_system.hpp"
+
+#include <algorithm>
+
+namespace {
+// Jobs each queue has room for before Dispatch has to grow it. Dispatch refills queues in
+// place, so this only decides whether the first large ParallelFor allocates mid-game.
+constexpr std::size_t kReservedJobsPerQueue = 256;
+}
+
+void JobSystem::Init(int worker_threads) {
+    Shutdown();
+    stopping_ = false;
+
+    const int threads = std::max(worker_threads, 0) + 1;
+    for (int i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+        queues_.back()->jobs.reserve(kReservedJobsPerQueue);
+    }
+    for (int i = 1; i < threads; ++i) {
+        threads_.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+void JobSystem::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+    queues_.clear();
+}
+
+int JobSystem::DefaultWorkerThreads() {
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? static_cast<int>(hardware) - 1 : 0;
+}
+
+void JobSystem::Dispatch(int count, int grain, void (*run)(void*, int, int, int), void* context) {
+    const int chunks = ChunkCount(count, grain);
+    unfinished_.store(chunks, std::memory_order_relaxed);
+
+    // Deal chunks out round-robin so every worker starts with local work.
+    const int threads = ThreadCount();
+    for (int t = 0; t < threads; ++t) {
+        Queue& queue = *queues_[t];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.clear();
+        queue.first = 0;
+        for (int chunk = t; chunk < chunks; chunk += threads) {
+            const int begin = chunk * grain;
+            queue.jobs.push_back(Job{run, context, chunk, begin, std::min(begin + grain, count)});
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        queued_.fetch_add(chunks, std::memory_order_release);
+    }
+    wake_.notify_all();
+
+    // Help out until every chunk has finished, not just until the queues are empty.
+    Job job;
+    while (unfinished_.load(std::memory_order_acquire) > 0) {
+        if (TakeJob(0, &job)) {
+            RunJob(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::TakeJob(int self, Job* job) {
+    if (queued_.load(std::memory_order_acquire) <= 0) {
+        return false;
+    }
+
+    {
+        Queue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.jobs.size() > own.first) {
+            *job = own.jobs.back();
+            own.jobs.pop_back();
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    const int threads = ThreadCount();
+    for (int offset = 1; offset < threads; ++offset) {
+        Queue& victim = *queues_[(self + offset) % threads];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.jobs.size() > victim.first) {
+            *job = victim.jobs[victim.first++];
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::RunJob(const Job& job) {
+    job.run(job.context, job.chunk, job.begin, job.end);
+    unfinished_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::WorkerLoop(int self) {
+    Job job;
+    for (;;) {
+        if (TakeJob(self, &job)) {
+            RunJob(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+        if (stopping_) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed pool of worker threads with one job queue each. A worker pops the newest job from
+// its own queue and, once that is empty, steals the oldest from another worker's. The
+// thread calling ParallelFor works too, as worker 0, until its loop is done.
+//
+// Work is cut into chunks by count and grain only, never by thread count, so per-chunk
+// results merged in chunk order come out the same however many threads ran them, including
+// none (Init(0) runs every chunk inline, in order).
+class JobSystem {
+public:
+    JobSystem() = default;
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    ~JobSystem() { Shutdown(); }
+
+    // Starts worker_threads threads besides the caller.
+    void Init(int worker_threads);
+    void Shutdown();
+    // Threads that take part in a ParallelFor, counting the caller.
+    int ThreadCount() const { return static_cast<int>(queues_.size()); }
+    // One worker per hardware thread besides the caller.
+    static int DefaultWorkerThreads();
+
+    static int ChunkCount(int count, int grain) { return count <= 0 ? 0 : (count + grain - 1) / grain; }
+
+    // Calls fn(chunk, begin, end) for every chunk of [0, count) and returns once all have
+    // run. Chunks may run concurrently and in any order; fn must not call ParallelFor.
+    template <typename Fn>
+    void ParallelFor(int count, int grain, Fn&& fn);
+
+private:
+    struct Job {
+        void (*run)(void* context, int chunk, int begin, int end);
+        void* context;
+        int chunk;
+        int begin;
+        int end;
+    };
+
+    // The owner takes from the back, thieves from the front. Jobs [first, jobs.size()) are
+    // queued; a queue is only refilled once empty, so it keeps its capacity and Dispatch
+    // stops allocating after the largest ParallelFor has run once.
+    struct Queue {
+        std::mutex mutex;
+        std::vector<Job> jobs;
+        std::size_t first = 0;
+    };
+
+    void Dispatch(int count, int grain, void (*run)(void*, int, int, int), void* context);
+    bool TakeJob(int self, Job* job);
+    void RunJob(const Job& job);
+    void WorkerLoop(int self);
+
+    std::vector<std::unique_ptr<Queue>> queues_{};  // [0] belongs to the calling thread
+    std::vector<std::thread> threads_{};
+    std::mutex wake_mutex_{};
+    std::condition_variable wake_{};
+    std::atomic<int> queued_{0};     // jobs sitting in any queue
+    std::atomic<int> unfinished_{0}; // jobs of the current ParallelFor not yet done
+    bool stopping_ = false;
+};
+
+template <typename Fn>
+void JobSystem::ParallelFor(int count, int grain, Fn&& fn) {
+    const int chunks = ChunkCount(count, grain);
+    if (chunks <= 1 || threads_.empty()) {
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            const int begin = chunk * grain;
+            fn(chunk, begin, std::min(begin + grain, count));
+        }
+        return;
+    }
+
+    using Body = std::remove_reference_t<Fn>;
+    Dispatch(count, grain, [](void* context, int chunk, int begin, int end) {
+        (*static_cast<Body*>(context))(chunk, begin, end);
+    }, const_cast<void*>(static_cast<const void*>(&fn)));
+}
+
+// Per-chunk output of a ParallelFor. Each chunk appends only to its own list; reading the
+// lists back in chunk order gives what a serial loop would have produced. Lists keep their
+// capacity across Reset, so steady-state ticks do not allocate.
+template <typename T>
+class ChunkedOutput {
+public:
+    // per_chunk, when given, is the most one chunk can output; lists are sized for it now
+    // rather than grown on the tick that first needs it.
+    void Reset(int chunks, std::size_t per_chunk = 0) {
+        if (static_cast<int>(lists_.size()) < chunks) {
+            lists_.resize(chunks);
+        }
+        for (std::vector<T>& list : lists_) {
+            list.clear();
+        }
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            lists_[chunk].reserve(per_chunk);
+        }
+        chunks_ = chunks;
+    }
+
+    std::vector<T>& operator[](int chunk) { return lists_[chunk]; }
+
+    template <typename Fn>
+    void ForEachInOrder(Fn&& fn) const {
+        for (int chunk = 0; chunk < chunks_; ++chunk) {
+            for (const T& item : lists_[chunk]) {
+                fn(item);
+            }
+        }
+    }
+
+private:
+    std::vector<std::vector<T>> lists_{};
+    int chunks_ = 0;
+};
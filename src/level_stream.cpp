@@ -0,0 +1,325 @@
+#include "level_stream.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr int kGroundHeight = 40;
+constexpr int kBushWidth = 70;
+constexpr int kBushHeight = 80;
+constexpr int kBushGroundOffset = 100;  // bush top, up from the bottom of the screen
+
+// Chunks within this distance of the view are active: simulated and collidable.
+constexpr int kActiveMargin = 256;
+// Active chunks stay until the view is this far past them, so turning round at a chunk
+// border does not drop and reload it every few ticks.
+constexpr int kKeepMargin = kActiveMargin + 512;
+// Chunks within this distance are read ahead of time.
+constexpr int kPrefetchMargin = kActiveMargin + LevelStreamer::kChunkWidth;
+}
+
+bool LoadLevelChunk(const fs::path& path, int index, int screen_height, LevelChunk* out) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot open level chunk " << path << "\n";
+        return false;
+    }
+
+    out->index = index;
+    const int origin = index * LevelStreamer::kChunkWidth;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind)) {
+            continue;
+        }
+
+        bool ok = false;
+        if (kind == "ground") {
+            SDL_Rect r{0, screen_height - kGroundHeight, 0, kGroundHeight};
+            ok = static_cast<bool>(fields >> r.x >> r.w);
+            r.x += origin;
+            out->grounds.push_back(r);
+        } else if (kind == "branch") {
+            SDL_Rect r{};
+            ok = static_cast<bool>(fields >> r.x >> r.y >> r.w >> r.h);
+            r.x += origin;
+            out->branches.push_back(r);
+        } else if (kind == "tree") {
+            SDL_Rect r{0, 0, 0, screen_height};
+            ok = static_cast<bool>(fields >> r.x >> r.w);
+            r.x += origin;
+            out->trees.push_back(r);
+        } else if (kind == "bush") {
+            SDL_Rect r{0, screen_height - kBushGroundOffset, kBushWidth, kBushHeight};
+            ok = static_cast<bool>(fields >> r.x);
+            r.x += origin;
+            out->bushes.push_back(r);
+        } else if (kind == "squirrel") {
+            SDL_FPoint p{};
+            ok = static_cast<bool>(fields >> p.x >> p.y);
+            p.x += static_cast<float>(origin);
+            out->squirrels.push_back(p);
+        }
+
+        if (!ok) {
+            std::cerr << path.string() << ":" << line_number << ": cannot parse '" << line << "'\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LevelStreamer::Open(const std::vector<fs::path>& dirs, int screen_height) {
+    Close();
+    screen_height_ = screen_height;
+    for (const fs::path& dir : dirs) {
+        dir_ = dir;
+        if (fs::exists(ChunkPath(0))) {
+            break;
+        }
+    }
+
+    chunk_count_ = 0;
+    while (fs::exists(ChunkPath(chunk_count_))) {
+        ++chunk_count_;
+    }
+    if (chunk_count_ == 0) {
+        std::cerr << "No level chunks (chunk_000.txt) found\n";
+        return false;
+    }
+
+    // Only the chunks around the view are ever tracked; room for them up front keeps
+    // Update from allocating while the level streams.
+    const std::size_t tracked = 2 * (kPrefetchMargin / kChunkWidth + 2) + 1;
+    for (auto* chunks : {&active_, &ready_, &loaded_}) {
+        chunks->reserve(tracked);
+    }
+    in_flight_.reserve(tracked);
+    requests_.reserve(tracked);
+
+    stopping_ = false;
+    loader_ = std::thread(&LevelStreamer::LoaderMain, this);
+    return true;
+}
+
+void LevelStreamer::Close() {
+    if (loader_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        requested_.notify_one();
+        loader_.join();
+    }
+    requests_.clear();
+    loaded_.clear();
+    active_.clear();
+    ready_.clear();
+    in_flight_.clear();
+    chunk_count_ = 0;
+}
+
+fs::path LevelStreamer::ChunkPath(int index) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "chunk_%03d.txt", index);
+    return dir_ / name;
+}
+
+LevelStreamer::Range LevelStreamer::ChunksAround(float view_left, int view_width, int margin) const {
+    const float left = view_left - static_cast<float>(margin);
+    const float right = view_left + static_cast<float>(view_width + margin);
+    const int first = static_cast<int>(std::floor(left / kChunkWidth));
+    const int last = static_cast<int>(std::ceil(right / kChunkWidth)) - 1;
+    return Range{std::max(first, 0), std::min(last, chunk_count_ - 1)};
+}
+
+void LevelStreamer::LoaderMain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        requested_.wait(lock, [this]() { return stopping_ || !requests_.empty(); });
+        if (stopping_) {
+            return;
+        }
+        const int index = requests_.front();
+        requests_.erase(requests_.begin());
+
+        // The read happens unlocked; a chunk that fails to load arrives empty rather than
+        // leaving Update waiting for it.
+        lock.unlock();
+        auto chunk = std::make_unique<LevelChunk>();
+        if (!LoadLevelChunk(ChunkPath(index), index, screen_height_, chunk.get())) {
+            *chunk = LevelChunk{};
+            chunk->index = index;
+        }
+        lock.lock();
+
+        loaded_.push_back(std::move(chunk));
+        loaded_cv_.notify_one();
+    }
+}
+
+void LevelStreamer::CollectLoaded() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::unique_ptr<LevelChunk>& chunk : loaded_) {
+        in_flight_.erase(std::find(in_flight_.begin(), in_flight_.end(), chunk->index));
+        ready_.push_back(std::move(chunk));
+        ++loads_;
+    }
+    loaded_.clear();
+}
+
+void LevelStreamer::Request(int index) {
+    in_flight_.push_back(index);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.push_back(index);
+    }
+    requested_.notify_one();
+}
+
+std::unique_ptr<LevelChunk> LevelStreamer::TakeReady(int index) {
+    auto has_index = [index](const std::unique_ptr<LevelChunk>& chunk) { return chunk->index == index; };
+    auto it = std::find_if(ready_.begin(), ready_.end(), has_index);
+    if (it == ready_.end()) {
+        // Nothing is active only at the start, where waiting is expected.
+        if (!active_.empty()) {
+            ++stalls_;
+        }
+        if (std::find(in_flight_.begin(), in_flight_.end(), index) == in_flight_.end()) {
+            Request(index);
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            loaded_cv_.wait(lock, [&]() { return std::any_of(loaded_.begin(), loaded_.end(), has_index); });
+        }
+        CollectLoaded();
+        it = std::find_if(ready_.begin(), ready_.end(), has_index);
+    }
+
+    std::unique_ptr<LevelChunk> chunk = std::move(*it);
+    ready_.erase(it);
+    return chunk;
+}
+
+void LevelStreamer::Update(float view_left, int view_width, std::vector<const LevelChunk*>* activated,
+                           std::vector<int>* deactivated) {
+    activated->clear();
+    deactivated->clear();
+    if (chunk_count_ == 0) {
+        return;
+    }
+
+    const Range active = ChunksAround(view_left, view_width, kActiveMargin);
+    const Range keep = ChunksAround(view_left, view_width, kKeepMargin);
+    const Range prefetch = ChunksAround(view_left, view_width, kPrefetchMargin);
+    CollectLoaded();
+
+    // Deactivate active chunks beyond the keep range, then free everything beyond the
+    // prefetch range. Chunks in between stay read so turning back does not reload them.
+    for (auto it = active_.begin(); it != active_.end();) {
+        if (keep.Contains((*it)->index)) {
+            ++it;
+        } else {
+            deactivated->push_back((*it)->index);
+            ready_.push_back(std::move(*it));
+            it = active_.erase(it);
+        }
+    }
+    ready_.erase(std::remove_if(ready_.begin(), ready_.end(),
+                                [&](const std::unique_ptr<LevelChunk>& chunk) {
+                                    return !prefetch.Contains(chunk->index);
+                                }),
+                 ready_.end());
+
+    auto is_active = [this](int index) {
+        return std::any_of(active_.begin(), active_.end(),
+                           [index](const std::unique_ptr<LevelChunk>& chunk) { return chunk->index == index; });
+    };
+    auto is_ready = [this](int index) {
+        return std::any_of(ready_.begin(), ready_.end(),
+                           [index](const std::unique_ptr<LevelChunk>& chunk) { return chunk->index == index; });
+    };
+
+    // Nearest chunks first, so the loader reads them in the order the view reaches them.
+    const float view_centre = view_left + view_width * 0.5f;
+    const int centre = static_cast<int>(std::floor(view_centre / kChunkWidth));
+    const int farthest = std::max(std::abs(prefetch.first - centre), std::abs(prefetch.last - centre));
+    for (int distance = 0; distance <= farthest; ++distance) {
+        for (int index : {centre + distance, centre - distance}) {
+            if (!prefetch.Contains(index) || is_active(index) || is_ready(index) ||
+                std::find(in_flight_.begin(), in_flight_.end(), index) != in_flight_.end()) {
+                continue;
+            }
+            Request(index);
+        }
+    }
+
+    for (int index = active.first; index <= active.last; ++index) {
+        if (!is_active(index)) {
+            active_.push_back(TakeReady(index));
+            activated->push_back(active_.back().get());
+        }
+    }
+    std::sort(active_.begin(), active_.end(),
+              [](const std::unique_ptr<LevelChunk>& a, const std::unique_ptr<LevelChunk>& b) {
+                  return a->index < b->index;
+              });
+}
+
+bool LevelStreamer::SetActive(const std::vector<int>& indices, std::vector<const LevelChunk*>* activated,
+                              std::vector<int>* deactivated) {
+    activated->clear();
+    deactivated->clear();
+    for (const int index : indices) {
+        if (index < 0 || index >= chunk_count_) {
+            return false;
+        }
+    }
+    CollectLoaded();
+
+    auto wanted = [&indices](int index) {
+        return std::find(indices.begin(), indices.end(), index) != indices.end();
+    };
+    for (auto it = active_.begin(); it != active_.end();) {
+        if (wanted((*it)->index)) {
+            ++it;
+        } else {
+            deactivated->push_back((*it)->index);
+            ready_.push_back(std::move(*it));
+            it = active_.erase(it);
+        }
+    }
+    for (const int index : indices) {
+        if (std::none_of(active_.begin(), active_.end(),
+                         [index](const std::unique_ptr<LevelChunk>& chunk) { return chunk->index == index; })) {
+            active_.push_back(TakeReady(index));
+            activated->push_back(active_.back().get());
+        }
+    }
+    std::sort(active_.begin(), active_.end(),
+              [](const std::unique_ptr<LevelChunk>& a, const std::unique_ptr<LevelChunk>& b) {
+                  return a->index < b->index;
+              });
+    return true;
+}
+
+float LevelStreamer::ActiveLeft() const {
+    return active_.empty() ? 0.0f : static_cast<float>(active_.front()->index * kChunkWidth);
+}
+
+float LevelStreamer::ActiveRight() const {
+    return active_.empty() ? 0.0f : static_cast<float>((active_.back()->index + 1) * kChunkWidth);
+}
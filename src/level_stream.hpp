@@ -0,0 +1,114 @@
+#pragma once
+
+#include <SDL.h>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A level is a row of fixed-width chunks, one text file each: chunk_000.txt, chunk_001.txt,
+// ... Chunk i covers world x in [i * kChunkWidth, (i + 1) * kChunkWidth). One item per
+// line, x relative to the chunk's left edge, '#' starts a comment:
+//
+//   ground x w           solid strip along the bottom of the screen
+//   branch x y w h       solid platform drawn with the branch sprite
+//   tree x w             scenery, full screen height
+//   bush x               scenery, standing on the ground
+//   squirrel x y         spawn point (bottom-left of the body)
+//
+// Everything below is in world space.
+struct LevelChunk {
+    int index = 0;
+    std::vector<SDL_Rect> grounds{};
+    std::vector<SDL_Rect> branches{};
+    std::vector<SDL_Rect> trees{};
+    std::vector<SDL_Rect> bushes{};
+    std::vector<SDL_FPoint> squirrels{};
+};
+
+// Parses one chunk file. On failure out holds whatever was read before the bad line.
+bool LoadLevelChunk(const std::filesystem::path& path, int index, int screen_height, LevelChunk* out);
+
+// Keeps only the chunks around the view resident. A loader thread reads chunks ahead of
+// the view; Update hands over the ones that came into range and drops the ones left
+// behind, so memory and simulation cost depend on the view, not on the level's length.
+//
+// Which chunks are active is a function of the view position alone: if a chunk is needed
+// before the loader has it, Update waits for it rather than activating it a tick late.
+// Prefetching a whole chunk ahead keeps that from happening at walking speed.
+class LevelStreamer {
+public:
+    static constexpr int kChunkWidth = 1024;
+
+    LevelStreamer() = default;
+    LevelStreamer(const LevelStreamer&) = delete;
+    LevelStreamer& operator=(const LevelStreamer&) = delete;
+    ~LevelStreamer() { Close(); }
+
+    // Uses the first of dirs holding chunk_000.txt and starts the loader thread.
+    bool Open(const std::vector<std::filesystem::path>& dirs, int screen_height);
+    void Close();
+
+    // Call once per tick with the view's world-space left edge and width. Chunks that
+    // became active are appended to activated (valid until they are dropped), the indices
+    // of chunks that were dropped to deactivated.
+    void Update(float view_left, int view_width, std::vector<const LevelChunk*>* activated,
+                std::vector<int>* deactivated);
+
+    // Makes exactly the chunks in indices active, for restoring a snapshot: which chunks are
+    // active depends on how the view got where it is, not just on where it is. Reports the
+    // changes like Update; waits for any chunk that is not read yet. False if an index is
+    // outside the level.
+    bool SetActive(const std::vector<int>& indices, std::vector<const LevelChunk*>* activated,
+                   std::vector<int>* deactivated);
+
+    // Resident chunks in index order.
+    const std::vector<std::unique_ptr<LevelChunk>>& Active() const { return active_; }
+    // World x span covered by the active chunks; empty (left == right) when there are none.
+    float ActiveLeft() const;
+    float ActiveRight() const;
+
+    int ChunkCount() const { return chunk_count_; }
+    // Chunk reads finished by the loader, and how many of those Update had to wait for.
+    int Loads() const { return loads_; }
+    int Stalls() const { return stalls_; }
+
+private:
+    struct Range {
+        int first;
+        int last;  // inclusive; first > last when empty
+        bool Contains(int index) const { return index >= first && index <= last; }
+    };
+
+    Range ChunksAround(float view_left, int view_width, int margin) const;
+    std::filesystem::path ChunkPath(int index) const;
+    void LoaderMain();
+    // Main thread: takes everything the loader has finished.
+    void CollectLoaded();
+    void Request(int index);
+    // Main thread: removes chunk index from ready_ (waiting for the loader if needed).
+    std::unique_ptr<LevelChunk> TakeReady(int index);
+
+    std::filesystem::path dir_{};
+    int screen_height_ = 0;
+    int chunk_count_ = 0;
+    int loads_ = 0;
+    int stalls_ = 0;
+
+    // Main thread only.
+    std::vector<std::unique_ptr<LevelChunk>> active_{};
+    std::vector<std::unique_ptr<LevelChunk>> ready_{};  // loaded, not active yet
+    std::vector<int> in_flight_{};
+
+    // Shared with the loader, under mutex_.
+    std::mutex mutex_{};
+    std::condition_variable requested_{};
+    std::condition_variable loaded_cv_{};
+    std::vector<int> requests_{};
+    std::vector<std::unique_ptr<LevelChunk>> loaded_{};
+    bool stopping_ = false;
+    std::thread loader_{};
+};
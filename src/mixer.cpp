@@ -0,0 +1,111 @@
+#include "mixer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr float kHalfPi = 1.57079632679f;
+
+// acc and src hold frames interleaved stereo frames.
+void MixInto(float* __restrict acc, const std::int16_t* __restrict src, int frames, float gain_left, float gain_right) {
+    for (int i = 0; i < frames; ++i) {
+        acc[2 * i] += static_cast<float>(src[2 * i]) * gain_left;
+        acc[2 * i + 1] += static_cast<float>(src[2 * i + 1]) * gain_right;
+    }
+}
+
+void ToInt16(const float* __restrict acc, std::int16_t* __restrict out, int samples, float master_gain) {
+    for (int i = 0; i < samples; ++i) {
+        const float value = std::min(std::max(acc[i] * master_gain, -32768.0f), 32767.0f);
+        out[i] = static_cast<std::int16_t>(value);
+    }
+}
+}
+
+bool Mixer::Push(const Command& command) {
+    if (!commands_.TryPush(command)) {
+        ++dropped_commands_;
+        return false;
+    }
+    return true;
+}
+
+bool Mixer::Play(const SoundBuffer& sound, float gain, float pan) {
+    return Push(Command{CommandType::kPlay, sound.samples.data(), sound.Frames(), gain, pan});
+}
+
+bool Mixer::SetMasterGain(float gain) {
+    return Push(Command{CommandType::kSetMasterGain, nullptr, 0, gain, 0.0f});
+}
+
+void Mixer::StartVoice(Voice* voice, const Command& command) {
+    if (command.frames == 0) {
+        *voice = Voice{};
+        return;
+    }
+    // Equal-power pan: the centre sits at -3 dB per side, so moving a sound keeps its loudness.
+    const float angle = (std::min(std::max(command.pan, -1.0f), 1.0f) + 1.0f) * 0.5f * kHalfPi;
+    voice->samples = command.samples;
+    voice->frames = command.frames;
+    voice->position = 0;
+    voice->gain_left = command.gain * std::cos(angle);
+    voice->gain_right = command.gain * std::sin(angle);
+}
+
+void Mixer::ApplyCommands() {
+    Command command;
+    while (commands_.TryPop(&command)) {
+        switch (command.type) {
+        case CommandType::kPlay: {
+            auto free_voice = std::find_if(voices_.begin(), voices_.end(),
+                                           [](const Voice& voice) { return !voice.samples; });
+            if (free_voice == voices_.end()) {
+                ++dropped_voices_;
+                break;
+            }
+            StartVoice(&*free_voice, command);
+            break;
+        }
+        case CommandType::kSetMasterGain:
+            master_gain_ = command.gain;
+            break;
+        }
+    }
+}
+
+void Mixer::Mix(std::int16_t* out, int frames) {
+    ApplyCommands();
+
+    for (int block_start = 0; block_start < frames; block_start += kBlockFrames) {
+        const int block_frames = std::min(kBlockFrames, frames - block_start);
+        std::fill(accumulator_.begin(), accumulator_.begin() + block_frames * 2, 0.0f);
+
+        if (music_) {
+            // A short read (the decoder fell behind) leaves the rest of the block silent.
+            const std::size_t wanted = static_cast<std::size_t>(block_frames) * 2;
+            const std::size_t got = music_->PopSome(music_block_.data(), wanted);
+            music_started_ = music_started_ || got > 0;
+            music_underruns_ += music_started_ && got < wanted ? 1 : 0;
+            MixInto(accumulator_.data(), music_block_.data(), static_cast<int>(got / 2), 1.0f, 1.0f);
+        }
+
+        for (Voice& voice : voices_) {
+            if (!voice.samples) {
+                continue;
+            }
+            const int run = static_cast<int>(
+                std::min<std::uint32_t>(voice.frames - voice.position, static_cast<std::uint32_t>(block_frames)));
+            MixInto(accumulator_.data(), voice.samples + voice.position * 2, run, voice.gain_left, voice.gain_right);
+            voice.position += static_cast<std::uint32_t>(run);
+            if (voice.position == voice.frames) {
+                voice = Voice{};
+            }
+        }
+
+        ToInt16(accumulator_.data(), out + block_start * 2, block_frames * 2, master_gain_);
+    }
+}
+
+int Mixer::ActiveVoices() const {
+    return static_cast<int>(std::count_if(voices_.begin(), voices_.end(), [](const Voice& voice) { return voice.samples != nullptr; }));
+}
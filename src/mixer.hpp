@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "spsc_queue.hpp"
+
+// Decoded PCM in the mixer's format: interleaved stereo int16 at the device rate.
+struct SoundBuffer {
+    std::vector<std::int16_t> samples{};
+
+    std::uint32_t Frames() const { return static_cast<std::uint32_t>(samples.size() / 2); }
+};
+
+// Streamed music arrives through this ring as interleaved stereo samples.
+using MusicRing = SpscQueue<std::int16_t, 16384>;
+
+// Fixed-voice software mixer run from the audio device callback. Voices play one-shot
+// effects; music is read from a MusicRing that another thread keeps filled. Play and the
+// setters are called from one gameplay thread and only queue a command; Mix, on the audio
+// thread, applies queued commands and then mixes. Nothing on either side allocates or
+// takes a lock.
+//
+// Voices accumulate into a float block with per-channel gain, and the block is converted
+// back to int16 with saturation. Both kernels are plain restrict loops, so a build with
+// optimisation enabled can vectorise them.
+class Mixer {
+public:
+    static constexpr int kMaxVoices = 32;
+    // Mix works through its output in blocks of this many frames.
+    static constexpr int kBlockFrames = 512;
+
+    // gain is linear (1 = as recorded); pan runs from -1 (left) to 1 (right). The buffer
+    // must outlive playback. Returns false if the command queue is full.
+    bool Play(const SoundBuffer& sound, float gain = 1.0f, float pan = 0.0f);
+    bool SetMasterGain(float gain);
+    // Must be set before the device starts calling Mix; null plays no music.
+    void SetMusicSource(MusicRing* music) { music_ = music; }
+    // Producer-side count of commands lost to a full queue.
+    int DroppedCommands() const { return dropped_commands_; }
+
+    // Audio thread: fills frames stereo frames of out.
+    void Mix(std::int16_t* out, int frames);
+    // Audio thread: voices that were playing at the end of the last Mix.
+    int ActiveVoices() const;
+    // Audio thread: blocks in which the music ring ran dry, after the first one arrived.
+    int MusicUnderruns() const { return music_underruns_; }
+    // Audio thread: Play commands that found every voice busy and were dropped.
+    int DroppedVoices() const { return dropped_voices_; }
+
+private:
+    enum class CommandType : std::uint8_t { kPlay, kSetMasterGain };
+
+    struct Command {
+        CommandType type;
+        const std::int16_t* samples;
+        std::uint32_t frames;
+        float gain;
+        float pan;
+    };
+
+    struct Voice {
+        const std::int16_t* samples = nullptr;  // null when the voice is free
+        std::uint32_t frames = 0;
+        std::uint32_t position = 0;
+        float gain_left = 0.0f;
+        float gain_right = 0.0f;
+    };
+
+    bool Push(const Command& command);
+    void ApplyCommands();
+    static void StartVoice(Voice* voice, const Command& command);
+
+    SpscQueue<Command, 256> commands_{};
+    int dropped_commands_ = 0;
+
+    std::array<Voice, kMaxVoices> voices_{};
+    float master_gain_ = 1.0f;
+    int dropped_voices_ = 0;
+    MusicRing* music_ = nullptr;
+    bool music_started_ = false;
+    int music_underruns_ = 0;
+    alignas(32) std::array<float, kBlockFrames * 2> accumulator_{};
+    alignas(32) std::array<std::int16_t, kBlockFrames * 2> music_block_{};
+};
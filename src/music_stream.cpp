@@ -0,0 +1,154 @@
+#include "music_stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+constexpr std::uint16_t kWaveFormatPcm = 1;
+constexpr std::uint16_t kWaveFormatFloat = 3;
+constexpr std::uint16_t kWaveFormatExtensible = 0xfffe;
+
+std::uint32_t ReadLE32(const unsigned char* bytes) {
+    return static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8) |
+           (static_cast<std::uint32_t>(bytes[2]) << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+}
+
+std::uint16_t ReadLE16(const unsigned char* bytes) {
+    return static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+// Maps a WAV fmt chunk onto an SDL sample format; 0 means unsupported.
+SDL_AudioFormat SourceFormat(std::uint16_t tag, std::uint16_t bits) {
+    if (tag == kWaveFormatPcm) {
+        if (bits == 8) return AUDIO_U8;
+        if (bits == 16) return AUDIO_S16LSB;
+        if (bits == 32) return AUDIO_S32LSB;
+    } else if (tag == kWaveFormatFloat && bits == 32) {
+        return AUDIO_F32LSB;
+    }
+    return 0;
+}
+}
+
+MusicDecoder::MusicDecoder() : block_(kFileBlockBytes) {}
+
+MusicDecoder::~MusicDecoder() {
+    Close();
+}
+
+bool MusicDecoder::Open(const std::filesystem::path& path, const SDL_AudioSpec& device_spec) {
+    Close();
+
+    file_.open(path, std::ios::binary);
+    unsigned char riff[12];
+    if (!file_ || !file_.read(reinterpret_cast<char*>(riff), sizeof(riff)) ||
+        std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        std::cerr << "Music " << path << " is missing or not a WAV file\n";
+        Close();
+        return false;
+    }
+
+    // Walk the chunks for "fmt " and "data"; anything else (LIST, fact, ...) is skipped.
+    SDL_AudioFormat format = 0;
+    std::uint16_t channels = 0;
+    std::uint32_t rate = 0;
+    unsigned char chunk[8];
+    while (file_.read(reinterpret_cast<char*>(chunk), sizeof(chunk))) {
+        const std::uint32_t size = ReadLE32(chunk + 4);
+        const std::uint64_t body = static_cast<std::uint64_t>(file_.tellg());
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            unsigned char fmt[40] = {};
+            file_.read(reinterpret_cast<char*>(fmt), std::min<std::uint32_t>(size, sizeof(fmt)));
+            std::uint16_t tag = ReadLE16(fmt);
+            if (tag == kWaveFormatExtensible && size >= 26) {
+                tag = ReadLE16(fmt + 24);  // first two bytes of the sub-format GUID
+            }
+            channels = ReadLE16(fmt + 2);
+            rate = ReadLE32(fmt + 4);
+            frame_bytes_ = ReadLE16(fmt + 12);
+            format = SourceFormat(tag, ReadLE16(fmt + 14));
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            data_begin_ = body;
+            data_size_ = size;
+            break;
+        }
+        // Chunks are padded to an even size.
+        file_.seekg(static_cast<std::streamoff>(body + size + (size & 1)));
+    }
+
+    if (format == 0 || channels == 0 || rate == 0 || frame_bytes_ == 0) {
+        std::cerr << "Music " << path << " is not uncompressed PCM\n";
+        Close();
+        return false;
+    }
+    data_size_ -= data_size_ % frame_bytes_;
+    if (data_size_ == 0) {
+        std::cerr << "Music " << path << " has no samples\n";
+        Close();
+        return false;
+    }
+
+    stream_ = SDL_NewAudioStream(format, static_cast<Uint8>(channels), static_cast<int>(rate),
+                                 device_spec.format, device_spec.channels, device_spec.freq);
+    if (!stream_) {
+        std::cerr << "Failed to create converter for " << path << ": " << SDL_GetError() << "\n";
+        Close();
+        return false;
+    }
+
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(data_begin_));
+    data_read_ = 0;
+    return true;
+}
+
+void MusicDecoder::Close() {
+    if (stream_) {
+        SDL_FreeAudioStream(stream_);
+        stream_ = nullptr;
+    }
+    file_.close();
+    file_.clear();
+    data_begin_ = 0;
+    data_size_ = 0;
+    data_read_ = 0;
+    frame_bytes_ = 0;
+}
+
+bool MusicDecoder::Refill() {
+    if (data_read_ == data_size_) {
+        // Looping just rewinds the file; the converter keeps its state, so there is no seam.
+        file_.clear();
+        file_.seekg(static_cast<std::streamoff>(data_begin_));
+        data_read_ = 0;
+    }
+
+    std::uint64_t want = std::min<std::uint64_t>(block_.size(), data_size_ - data_read_);
+    want -= want % frame_bytes_;
+    if (want == 0 || !file_.read(block_.data(), static_cast<std::streamsize>(want))) {
+        return false;
+    }
+    data_read_ += want;
+    return SDL_AudioStreamPut(stream_, block_.data(), static_cast<int>(want)) == 0;
+}
+
+int MusicDecoder::Read(std::int16_t* out, int samples) {
+    if (!stream_) {
+        return 0;
+    }
+
+    int written = 0;
+    while (written < samples) {
+        const int bytes = SDL_AudioStreamGet(stream_, out + written,
+                                             (samples - written) * static_cast<int>(sizeof(std::int16_t)));
+        if (bytes < 0) {
+            break;
+        }
+        written += bytes / static_cast<int>(sizeof(std::int16_t));
+        if (written < samples && !Refill()) {
+            break;
+        }
+    }
+    return written;
+}
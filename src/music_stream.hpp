@@ -0,0 +1,42 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// Decodes a PCM WAV file a block at a time and converts it to the device format, so a
+// track of any length costs one block of file data plus SDL's converter state. Only
+// uncompressed WAV (integer or float PCM) is supported.
+class MusicDecoder {
+public:
+    // Raw file bytes read per refill.
+    static constexpr std::size_t kFileBlockBytes = 16384;
+
+    MusicDecoder();
+    ~MusicDecoder();
+    MusicDecoder(const MusicDecoder&) = delete;
+    MusicDecoder& operator=(const MusicDecoder&) = delete;
+
+    // device_spec describes the output format (the one the audio device was opened with).
+    bool Open(const std::filesystem::path& path, const SDL_AudioSpec& device_spec);
+    void Close();
+    bool IsOpen() const { return stream_ != nullptr; }
+
+    // Fills out with samples converted samples (a whole number of frames), starting the
+    // track over when it runs out. Returns fewer only if the file cannot be read.
+    int Read(std::int16_t* out, int samples);
+
+private:
+    bool Refill();
+
+    std::ifstream file_{};
+    std::uint64_t data_begin_ = 0;
+    std::uint64_t data_size_ = 0;
+    std::uint64_t data_read_ = 0;
+    std::uint32_t frame_bytes_ = 0;  // source bytes per frame, so refills stay frame-aligned
+    SDL_AudioStream* stream_ = nullptr;
+    std::vector<char> block_{};
+};
@@ -1,61 +1,71 @@
 #include "player.hpp"
+#include "collision.hpp"
+#include "profiler.hpp"
 #include "game.hpp"
 #include <algorithm>
 #include <cmath>
+#include <utility>
 
+static const int kDefaultWidth = 48;
+static const int kDefaultHeight = 64;
 static const float kMoveSpeed = 260.0f;
 static const float kJumpVelocity = -520.0f;
 static const float kGravity = 1400.0f;
 static const float kPunchDuration = 0.18f;
 static const float kHeelKickDuration = 0.6f;
-static const float kIdleFrameDuration = 0.12f;
-static const float kWalkFrameDuration = 0.10f;
-static const float kPunchFrameDuration = 0.06f;
-static const float kJumpFrameDuration = 0.08f;
-static const float kHeelKickFrameDuration = 0.05f;
+// Contacts resolved per tick: e.g. a wall, then the floor the body slides down onto.
+static const int kMaxContactsPerTick = 3;
 
-void Player::SetTexture(const TextureSet& texture_set) {
-    base_texture_ = texture_set;
+void Player::Attach(Registry* registry) {
+    registry_ = registry;
+    entity_ = registry->Create();
+    registry->transforms.Add(entity_);
+    registry->velocities.Add(entity_);
+    registry->colliders.Add(entity_, Collider{kDefaultWidth, kDefaultHeight});
+    registry->animations.Add(entity_);
 }
 
-void Player::SetIdleTextures(const TextureSet& textures) {
-    idle_textures_ = textures;
-    idle_frame_ = 0;
-    idle_frame_time_ = 0.0f;
+void Player::SetPosition(float x, float y) {
+    registry_->transforms.Get(entity_) = Transform{x, y, x, y};
 }
 
-void Player::SetWalkTextures(const TextureSet& textures) {
-    walk_textures_ = textures;
-    walk_frame_ = 0;
-    walk_frame_time_ = 0.0f;
+float Player::GetX() const {
+    return registry_->transforms.Get(entity_).x;
 }
 
-void Player::SetPunchTextures(const TextureSet& textures) {
-    punch_textures_ = textures;
-    punch_frame_ = 0;
-    punch_frame_time_ = 0.0f;
+float Player::GetY() const {
+    return registry_->transforms.Get(entity_).y;
 }
-void Player::SetJumpTextures(const TextureSet& textures) {
-    jump_textures_ = textures;
-    jump_frame_ = 0;
-    jump_frame_time_ = 0.0f;
+
+SDL_FPoint Player::GetMotion() const {
+    const Transform& t = registry_->transforms.Get(entity_);
+    return SDL_FPoint{t.x - t.prev_x, t.y - t.prev_y};
 }
 
-void Player::SetHeelKickTextures(const TextureSet& textures) {
-    heel_kick_textures_ = textures;
-    heel_kick_frame_ = 0;
-    heel_kick_frame_time_ = 0.0f;
+void Player::SetTexture(TextureHandle texture_set) {
+    base_texture_ = std::move(texture_set);
+
+    // The body is the size of the base sprite.
+    Collider& collider = registry_->colliders.Get(entity_);
+    collider.width = base_texture_ && base_texture_->width > 0 ? base_texture_->width : kDefaultWidth;
+    collider.height = base_texture_ && base_texture_->height > 0 ? base_texture_->height : kDefaultHeight;
+}
+
+void Player::SetAnimations(const AnimationLibrary* library, const PlayerClips& clips) {
+    animations_ = library;
+    clips_ = clips;
+    registry_->animations.Get(entity_) = AnimationState{};
 }
 
 SDL_Rect Player::GetBodyRect() const {
-    int draw_w = base_texture_.width > 0 ? base_texture_.width : 48;
-    int draw_h = base_texture_.height > 0 ? base_texture_.height : 64;
+    const Transform& t = registry_->transforms.Get(entity_);
+    const Collider& c = registry_->colliders.Get(entity_);
 
     return SDL_Rect{
-        static_cast<int>(x_),
-        static_cast<int>(y_) - draw_h,
-        draw_w,
-        draw_h
+        static_cast<int>(t.x),
+        static_cast<int>(t.y) - c.height,
+        c.width,
+        c.height
     };
 }
 
@@ -75,68 +85,131 @@ SDL_Rect Player::GetAttackRect() const {
 }
 
 void Player::ApplyKnockback(float vx, float vy) {
-    vx_ = vx;
-    vy_ = vy;
+    Velocity& v = registry_->velocities.Get(entity_);
+    v.vx = vx;
+    v.vy = vy;
     on_ground_ = false;
 }
 
-void Player::CheckPlatformCollisions(const std::vector<Platform>& platforms) {
+void Player::CheckPlatformCollisions(const StaticGrid& platform_grid, const StaticGrid* solid_grid) {
+    Transform& t = registry_->transforms.Get(entity_);
+    Velocity& v = registry_->velocities.Get(entity_);
+    const Collider& c = registry_->colliders.Get(entity_);
     on_ground_ = false;
 
-    SDL_Rect playerRect = GetBodyRect();
+    const float width = static_cast<float>(c.width);
+    const float height = static_cast<float>(c.height);
 
-    for (const auto& platform : platforms) {
-        SDL_Rect p = platform.rect;
+    // Move the body along this tick's path up to the first contact, stop the part of the
+    // motion going into that face, and sweep what is left.
+    SDL_FRect body{t.prev_x, t.prev_y - height, width, height};
+    SDL_FPoint delta{t.x - t.prev_x, t.y - t.prev_y};
+    bool contact = false;
+    for (int pass = 0; pass < kMaxContactsPerTick && (delta.x != 0.0f || delta.y != 0.0f); ++pass) {
+        SweepHit first{};
+        SDL_Rect first_rect{};
+        bool hit = false;
+        auto consider = [&](const SDL_Rect& r, bool solid) {
+            SweepHit h;
+            if (!SweepBox(body, delta, ToFRect(r), &h)) {
+                return;
+            }
+            // A zero normal means the body already overlaps r, which no sweep can resolve.
+            const bool overlapping = h.normal_x == 0.0f && h.normal_y == 0.0f;
+            const bool blocks = solid ? !overlapping : h.normal_y < 0.0f;
+            if (!blocks || (hit && h.time >= first.time)) {
+                return;
+            }
+            first = h;
+            first_rect = r;
+            hit = true;
+        };
+        const SDL_Rect area = SweptBounds(body, delta);
+        platform_grid.Query(area, [&](int index) { consider(platform_grid.Rect(index), false); });
+        if (solid_grid) {
+            solid_grid->Query(area, [&](int index) { consider(solid_grid->Rect(index), true); });
+        }
+        if (!hit) {
+            body.x += delta.x;
+            body.y += delta.y;
+            break;
+        }
 
-        // Check if falling and hitting top of platform
-        if (vy_ >= 0 &&
-            playerRect.y + playerRect.h <= p.y + 10 && // was above platform
-            playerRect.y + playerRect.h >= p.y &&      // now touching
-            playerRect.x + playerRect.w > p.x &&
-            playerRect.x < p.x + p.w) {
+        // Snap onto the face exactly, so the next tick starts in contact rather than a
+        // rounding error inside or above it.
+        contact = true;
+        const float rest = 1.0f - first.time;
+        if (first.normal_y != 0.0f) {
+            body.x += delta.x * first.time;
+            body.y = first.normal_y < 0.0f ? static_cast<float>(first_rect.y) - height
+                                           : static_cast<float>(first_rect.y + first_rect.h);
+            delta = SDL_FPoint{delta.x * rest, 0.0f};
+            v.vy = 0.0f;
+            on_ground_ = on_ground_ || first.normal_y < 0.0f;
+        } else {
+            body.x = first.normal_x < 0.0f ? static_cast<float>(first_rect.x) - width
+                                           : static_cast<float>(first_rect.x + first_rect.w);
+            body.y += delta.y * first.time;
+            delta = SDL_FPoint{0.0f, delta.y * rest};
+            v.vx = 0.0f;
+        }
+    }
+    if (contact) {
+        t.x = body.x;
+        t.y = body.y + height;
+    }
 
-            y_ = static_cast<float>(p.y);
-            vy_ = 0.0f;
-            on_ground_ = true;
+    // Standing still on a top face moves the body no distance into it, so no sweep sees it.
+    if (!on_ground_ && v.vy >= 0.0f) {
+        const SDL_Rect feet{static_cast<int>(t.x), static_cast<int>(t.y), c.width, 1};
+        auto standing_on = [&](const SDL_Rect& r) {
+            on_ground_ = on_ground_ || static_cast<float>(r.y) == t.y;
+        };
+        platform_grid.Query(feet, [&](int index) { standing_on(platform_grid.Rect(index)); });
+        if (solid_grid) {
+            solid_grid->Query(feet, [&](int index) { standing_on(solid_grid->Rect(index)); });
         }
     }
 }
 
 void Player::Update(float dt, const InputState& input) {
+    PROFILE_SCOPE("Player::Update");
+    Transform& t = registry_->transforms.Get(entity_);
+    Velocity& v = registry_->velocities.Get(entity_);
     float move = 0.0f;
     if (input.move_left) move -= 1.0f;
     if (input.move_right) move += 1.0f;
-    vx_ = move * kMoveSpeed;
+    v.vx = move * kMoveSpeed;
 
-    if (vx_ < 0.0f) {
+    if (v.vx < 0.0f) {
         facing_left_ = true;
-    } else if (vx_ > 0.0f) {
+    } else if (v.vx > 0.0f) {
         facing_left_ = false;
     }
 
     if (on_ground_ && input.jump_pressed) {
-        vy_ = kJumpVelocity;
+        v.vy = kJumpVelocity;
         on_ground_ = false;
     }
 
-    if (!on_ground_ && input.heel_kick_pressed && !heel_kick_textures_.Empty()) {
+    // A fresh attack restarts its clip even if the same one is still playing.
+    ClipId started_clip = kNoClip;
+    if (!on_ground_ && input.heel_kick_pressed && clips_.heel_kick != kNoClip) {
         heel_kick_timer_ = kHeelKickDuration;
-        heel_kick_frame_ = 0;
-        heel_kick_frame_time_ = 0.0f;
         punch_timer_ = 0.0f;
+        started_clip = clips_.heel_kick;
     } else if (input.punch_pressed) {
         punch_timer_ = kPunchDuration;
-        punch_frame_ = 0;
-        punch_frame_time_ = 0.0f;
+        started_clip = clips_.punch;
     }
 
-    vy_ += kGravity * dt;
-    x_ += vx_ * dt;
-    y_ += vy_ * dt;
+    v.vy += kGravity * dt;
+    t.x += v.vx * dt;
+    t.y += v.vy * dt;
 
-    if (y_ >= ground_y_) {
-        y_ = ground_y_;
-        vy_ = 0.0f;
+    if (t.y >= ground_y_) {
+        t.y = ground_y_;
+        v.vy = 0.0f;
         on_ground_ = true;
     }
 
@@ -144,108 +217,82 @@ void Player::Update(float dt, const InputState& input) {
         heel_kick_timer_ -= dt;
         if (heel_kick_timer_ < 0.0f) heel_kick_timer_ = 0.0f;
     }
-    if (heel_kick_timer_ > 0.0f && !heel_kick_textures_.Empty()) {
-        heel_kick_frame_time_ += dt;
-        if (heel_kick_frame_time_ >= kHeelKickFrameDuration) {
-            heel_kick_frame_time_ = 0.0f;
-            if (heel_kick_frame_ + 1 < static_cast<int>(heel_kick_textures_.frames.size())) {
-                ++heel_kick_frame_;
-            }
-        }
-    }
-
     if (punch_timer_ > 0.0f) {
         punch_timer_ -= dt;
         if (punch_timer_ < 0.0f) punch_timer_ = 0.0f;
     }
-    if (punch_timer_ > 0.0f && !punch_textures_.Empty()) {
-        punch_frame_time_ += dt;
-        if (punch_frame_time_ >= kPunchFrameDuration) {
-            punch_frame_time_ = 0.0f;
-            if (punch_frame_ + 1 < static_cast<int>(punch_textures_.frames.size())) {
-                ++punch_frame_;
-            }
-        }
-    }
-
-    if (!on_ground_ && !jump_textures_.Empty()) {
-        jump_frame_time_ += dt;
-        if (jump_frame_time_ >= kJumpFrameDuration) {
-            jump_frame_time_ = 0.0f;
-            if (jump_frame_ + 1 < static_cast<int>(jump_textures_.frames.size())) {
-                ++jump_frame_;
-            }
-        }
-    } else {
-        jump_frame_ = 0;
-        jump_frame_time_ = 0.0f;
-    }
 
-    walk_active_ = on_ground_ && std::fabs(vx_) >= 0.01f;
-    if (walk_active_ && !walk_textures_.Empty()) {
-        walk_frame_time_ += dt;
-        if (walk_frame_time_ >= kWalkFrameDuration) {
-            walk_frame_time_ = 0.0f;
-            walk_frame_ = (walk_frame_ + 1) % static_cast<int>(walk_textures_.frames.size());
-        }
-    } else {
-        walk_frame_ = 0;
-        walk_frame_time_ = 0.0f;
-    }
-
-    idle_active_ = on_ground_ && std::fabs(vx_) < 0.01f;
-    if (idle_active_ && !idle_textures_.Empty()) {
-        idle_frame_time_ += dt;
-        if (idle_frame_time_ >= kIdleFrameDuration) {
-            idle_frame_time_ = 0.0f;
-            idle_frame_ = (idle_frame_ + 1) % static_cast<int>(idle_textures_.frames.size());
-        }
-    } else {
-        idle_frame_ = 0;
-        idle_frame_time_ = 0.0f;
+    // Highest priority first; AdvanceAnimations moves the chosen clip on with everyone else's.
+    const bool moving = std::fabs(v.vx) >= 0.01f;
+    ClipId clip = kNoClip;
+    if (heel_kick_timer_ > 0.0f && clips_.heel_kick != kNoClip) {
+        clip = clips_.heel_kick;
+    } else if (punch_timer_ > 0.0f && clips_.punch != kNoClip) {
+        clip = clips_.punch;
+    } else if (!on_ground_ && clips_.jump != kNoClip) {
+        clip = clips_.jump;
+    } else if (on_ground_ && moving && clips_.walk != kNoClip) {
+        clip = clips_.walk;
+    } else if (on_ground_ && !moving && clips_.idle != kNoClip) {
+        clip = clips_.idle;
     }
+    PlayClip(&registry_->animations.Get(entity_), clip, clip != kNoClip && clip == started_clip);
 }
 
-void Player::Render(SDL_Renderer* renderer, float camera_x) const {
-    int draw_w = base_texture_.width;
-    int draw_h = base_texture_.height;
-    if (draw_w <= 0) draw_w = 48;
-    if (draw_h <= 0) draw_h = 64;
-
-    SDL_Texture* render_texture = base_texture_.First();
-    if (heel_kick_timer_ > 0.0f && !heel_kick_textures_.Empty()) {
-        render_texture = heel_kick_textures_.frames[heel_kick_frame_];
-        draw_w = heel_kick_textures_.width;
-        draw_h = heel_kick_textures_.height;
-    } else if (punch_timer_ > 0.0f && !punch_textures_.Empty()) {
-        render_texture = punch_textures_.frames[punch_frame_];
-        draw_w = punch_textures_.width;
-        draw_h = punch_textures_.height;
-    } else if (!on_ground_ && !jump_textures_.Empty()) {
-        render_texture = jump_textures_.frames[jump_frame_];
-        draw_w = jump_textures_.width;
-        draw_h = jump_textures_.height;
-    } else if (walk_active_ && !walk_textures_.Empty()) {
-        render_texture = walk_textures_.frames[walk_frame_];
-        draw_w = walk_textures_.width;
-        draw_h = walk_textures_.height;
-    } else if (idle_active_ && !idle_textures_.Empty()) {
-        render_texture = idle_textures_.frames[idle_frame_];
-        draw_w = idle_textures_.width;
-        draw_h = idle_textures_.height;
+void Player::Render(SpriteBatch* batch, float camera_x, float alpha) const {
+    const Transform& t = registry_->transforms.Get(entity_);
+    int draw_w = base_texture_ ? base_texture_->width : 0;
+    int draw_h = base_texture_ ? base_texture_->height : 0;
+    if (draw_w <= 0) draw_w = kDefaultWidth;
+    if (draw_h <= 0) draw_h = kDefaultHeight;
+
+    const SpriteFrame* render_frame = base_texture_ ? base_texture_->First() : nullptr;
+    const AnimationState& anim = registry_->animations.Get(entity_);
+    if (animations_ && anim.clip != kNoClip) {
+        const TextureSet& clip_textures = *animations_->Get(anim.clip).textures;
+        render_frame = animations_->Frame(anim);
+        draw_w = clip_textures.width;
+        draw_h = clip_textures.height;
     }
 
+    const float x = t.prev_x + (t.x - t.prev_x) * alpha;
+    const float y = t.prev_y + (t.y - t.prev_y) * alpha;
     SDL_Rect body{
-        static_cast<int>(x_ - camera_x),
-        static_cast<int>(y_) - draw_h,
+        static_cast<int>(x - camera_x),
+        static_cast<int>(y) - draw_h,
         draw_w,
         draw_h
     };
-    if (render_texture) {
-        const SDL_RendererFlip flip = facing_left_ ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-        SDL_RenderCopyEx(renderer, render_texture, nullptr, &body, 0.0, nullptr, flip);
+    if (render_frame && render_frame->texture) {
+        batch->Draw(*render_frame, body, facing_left_);
     } else {
-        SDL_SetRenderDrawColor(renderer, 220, 220, 220, 255);
-        SDL_RenderFillRect(renderer, &body);
+        batch->FillRect(body, SDL_Color{220, 220, 220, 255});
     }
 }
+
+void Player::HashState(StateHasher* hasher) const {
+    hasher->Add(on_ground_);
+    hasher->Add(punch_timer_);
+    hasher->Add(heel_kick_timer_);
+    hasher->Add(facing_left_);
+}
+
+PlayerState Player::SaveState() const {
+    PlayerState state{};
+    state.entity = entity_;
+    state.ground_y = ground_y_;
+    state.punch_timer = punch_timer_;
+    state.heel_kick_timer = heel_kick_timer_;
+    state.on_ground = on_ground_;
+    state.facing_left = facing_left_;
+    return state;
+}
+
+void Player::RestoreState(const PlayerState& state) {
+    entity_ = state.entity;
+    ground_y_ = state.ground_y;
+    punch_timer_ = state.punch_timer;
+    heel_kick_timer_ = state.heel_kick_timer;
+    on_ground_ = state.on_ground;
+    facing_left_ = state.facing_left;
+}
@@ -1,64 +1,83 @@
 #pragma once
 #include <SDL.h>
 #include <vector>
+#include "animation.hpp"
 #include "input.hpp"
 #include "platform.hpp"
+#include "registry.hpp"
+#include "spatial_grid.hpp"
+#include "state_hash.hpp"
+#include "sprite_batch.hpp"
 #include "texture_set.hpp"
 
+// The clips Player switches between; kNoClip ones are skipped.
+struct PlayerClips {
+    ClipId idle = kNoClip;
+    ClipId walk = kNoClip;
+    ClipId jump = kNoClip;
+    ClipId punch = kNoClip;
+    ClipId heel_kick = kNoClip;
+};
+
+// Player's gameplay state outside the registry, as plain values for snapshots.
+struct PlayerState {
+    Entity entity = kNoEntity;
+    float ground_y = 0.0f;
+    float punch_timer = 0.0f;
+    float heel_kick_timer = 0.0f;
+    bool on_ground = false;
+    bool facing_left = false;
+    // Snapshots copy the struct's bytes, so the padding is spelled out and always zero.
+    std::uint8_t reserved[2] = {};
+};
+static_assert(sizeof(PlayerState) == 20, "PlayerState must have no implicit padding");
+
+// Position, velocity, body size and animation live in the registry as the player entity's
+// Transform, Velocity, Collider and AnimationState; Player keeps the input-driven state
+// around them and picks which clip plays.
 class Player {
 public:
-    void SetPosition(float x, float y) { x_ = x; y_ = y; }
+    // Creates the player entity; call before anything else.
+    void Attach(Registry* registry);
+    Entity GetEntity() const { return entity_; }
+
+    void SetPosition(float x, float y);
     void SetGroundY(float y) { ground_y_ = y; }
-    float GetX() const { return x_; }
-    float GetY() const { return y_; }
-    void SetTexture(const TextureSet& texture_set);
-    void SetIdleTextures(const TextureSet& textures);
-    void SetWalkTextures(const TextureSet& textures);
-    void SetPunchTextures(const TextureSet& textures);
-    void SetJumpTextures(const TextureSet& textures);
-    void SetHeelKickTextures(const TextureSet& textures);
+    float GetX() const;
+    float GetY() const;
+    // How far the player moved during the last tick.
+    SDL_FPoint GetMotion() const;
+    void SetTexture(TextureHandle texture_set);
+    // library must outlive the player; its clips are drawn instead of the base texture.
+    void SetAnimations(const AnimationLibrary* library, const PlayerClips& clips);
 
-    void CheckPlatformCollisions(const std::vector<Platform>& platforms);
+    // Resolves this tick's move (previous to current transform) against the level with
+    // swept boxes, so no speed or tick length tunnels through. Platforms are one-way: they
+    // only stop a fall onto their top. Solids also block from the sides and below.
+    void CheckPlatformCollisions(const StaticGrid& platform_grid, const StaticGrid* solid_grid = nullptr);
 
     void Update(float dt, const InputState& input);
-    void Render(SDL_Renderer* renderer, float camera_x) const;
+    void Render(SpriteBatch* batch, float camera_x, float alpha) const;
     SDL_Rect GetBodyRect() const;
     SDL_Rect GetAttackRect() const;
     void ApplyKnockback(float vx, float vy);
+    // Gameplay state kept outside the registry (timers, facing), for checksums.
+    void HashState(StateHasher* hasher) const;
+    // The entity's components are saved with the registry; these are the rest.
+    PlayerState SaveState() const;
+    void RestoreState(const PlayerState& state);
 
 private:
-    float x_ = 0.0f;
-    float y_ = 0.0f;
-    float vx_ = 0.0f;
-    float vy_ = 0.0f;
+    Registry* registry_ = nullptr;
+    Entity entity_ = kNoEntity;
     float ground_y_ = 0.0f;
     bool on_ground_ = false;
 
     float punch_timer_ = 0.0f;
-    float punch_frame_time_ = 0.0f;
-    int punch_frame_ = 0;
     float heel_kick_timer_ = 0.0f;
-    float heel_kick_frame_time_ = 0.0f;
-    int heel_kick_frame_ = 0;
-
-    TextureSet base_texture_{};
-
-    TextureSet jump_textures_{};
-    int jump_frame_ = 0;
-    float jump_frame_time_ = 0.0f;
-
-    TextureSet heel_kick_textures_{};
-
-    TextureSet idle_textures_{};
-    int idle_frame_ = 0;
-    float idle_frame_time_ = 0.0f;
-    bool idle_active_ = false;
-
-    TextureSet walk_textures_{};
-    int walk_frame_ = 0;
-    float walk_frame_time_ = 0.0f;
-    bool walk_active_ = false;
 
-    TextureSet punch_textures_{};
+    TextureHandle base_texture_{};
+    const AnimationLibrary* animations_ = nullptr;
+    PlayerClips clips_{};
     bool facing_left_ = false;
 };
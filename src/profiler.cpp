@@ -0,0 +1,157 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace profiler {
+namespace {
+constexpr std::size_t kEventsPerThread = 1 << 16;
+constexpr std::size_t kFrameWindow = 1024;
+
+struct Event {
+    const char* name;
+    std::int64_t start_ns;
+    std::int64_t duration_ns;
+};
+
+// Written only by its owning thread; head_ publishes finished events to the exporter.
+struct ThreadBuffer {
+    std::array<Event, kEventsPerThread> events{};
+    std::atomic<std::uint64_t> head{0};
+    int thread_id = 0;
+};
+
+std::atomic<bool> g_enabled{false};
+const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+// Buffers outlive their threads so a trace written at exit still has worker events. A
+// thread that exits hands its buffer back, and the next new thread records into it, so
+// threads that come and go do not each cost another ring.
+std::mutex g_buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+std::vector<ThreadBuffer*> g_free_buffers;
+
+std::array<float, kFrameWindow> g_frame_ms{};
+std::size_t g_frame_count = 0;
+
+// Returns the thread's buffer to the free list when the thread exits.
+struct BufferLease {
+    ThreadBuffer* buffer = nullptr;
+    ~BufferLease() {
+        if (buffer) {
+            std::lock_guard<std::mutex> lock(g_buffers_mutex);
+            g_free_buffers.push_back(buffer);
+        }
+    }
+};
+
+ThreadBuffer* LocalBuffer() {
+    thread_local BufferLease lease;
+    if (!lease.buffer) {
+        std::lock_guard<std::mutex> lock(g_buffers_mutex);
+        if (!g_free_buffers.empty()) {
+            lease.buffer = g_free_buffers.back();
+            g_free_buffers.pop_back();
+        } else {
+            g_buffers.push_back(std::make_unique<ThreadBuffer>());
+            lease.buffer = g_buffers.back().get();
+            lease.buffer->thread_id = static_cast<int>(g_buffers.size()) - 1;
+        }
+    }
+    return lease.buffer;
+}
+
+double Percentile(std::vector<float>& sorted, double fraction) {
+    const std::size_t index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+}
+
+void SetEnabled(bool enabled) {
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+std::int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void Record(const char* name, std::int64_t start_ns, std::int64_t end_ns) {
+    ThreadBuffer* buffer = LocalBuffer();
+    const std::uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[head % kEventsPerThread] = Event{name, start_ns, end_ns - start_ns};
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void AddFrameTime(double seconds) {
+    g_frame_ms[g_frame_count % kFrameWindow] = static_cast<float>(seconds * 1000.0);
+    ++g_frame_count;
+}
+
+FrameSummary SummarizeFrames() {
+    FrameSummary summary;
+    const std::size_t count = std::min(g_frame_count, kFrameWindow);
+    if (count == 0) {
+        return summary;
+    }
+
+    std::vector<float> sorted(g_frame_ms.begin(), g_frame_ms.begin() + count);
+    std::sort(sorted.begin(), sorted.end());
+    summary.frames = static_cast<int>(count);
+    summary.p50_ms = Percentile(sorted, 0.50);
+    summary.p95_ms = Percentile(sorted, 0.95);
+    summary.p99_ms = Percentile(sorted, 0.99);
+    return summary;
+}
+
+bool WriteChromeTrace(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    out << "{\"traceEvents\":[\n";
+    out << std::fixed << std::setprecision(3);
+    bool first = true;
+    std::vector<Event> events;
+    events.reserve(kEventsPerThread);
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : g_buffers) {
+        // Copy out everything published so far, then look at head again: the owner may have
+        // lapped the ring meanwhile, and the slots it reached (plus the one it may be
+        // writing now) hold newer events than the copy claims, so those are dropped.
+        const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const std::uint64_t begin = head > kEventsPerThread ? head - kEventsPerThread : 0;
+        events.clear();
+        for (std::uint64_t i = begin; i < head; ++i) {
+            events.push_back(buffer->events[i % kEventsPerThread]);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::uint64_t head_after = buffer->head.load(std::memory_order_relaxed);
+        const std::uint64_t overwritten = head_after >= kEventsPerThread ? head_after - kEventsPerThread + 1 : 0;
+        const std::size_t skip = static_cast<std::size_t>(std::min(head, std::max(begin, overwritten)) - begin);
+
+        for (std::size_t i = skip; i < events.size(); ++i) {
+            const Event& event = events[i];
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread_id
+                << ",\"ts\":" << static_cast<double>(event.start_ns) / 1000.0
+                << ",\"dur\":" << static_cast<double>(event.duration_ns) / 1000.0 << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+}
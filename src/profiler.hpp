@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Low-overhead scoped timers. Every thread appends finished scopes to its own fixed ring
+// buffer (a lock is taken only the first time a thread records), so the hot path is a
+// clock read and a store. WriteChromeTrace dumps the buffers as trace_event JSON for
+// chrome://tracing or Perfetto. While disabled, a scope costs one relaxed atomic load.
+namespace profiler {
+
+void SetEnabled(bool enabled);
+bool Enabled();
+
+// Nanoseconds since the profiler's epoch.
+std::int64_t NowNs();
+// name must outlive the profiler (string literals).
+void Record(const char* name, std::int64_t start_ns, std::int64_t end_ns);
+
+// Rolling window of whole-frame times, fed from the main loop.
+void AddFrameTime(double seconds);
+struct FrameSummary {
+    int frames = 0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+};
+FrameSummary SummarizeFrames();
+
+// Threads still recording while this runs may have their newest events skipped, and their
+// oldest ones too if they wrap their ring before it is copied.
+bool WriteChromeTrace(const std::string& path);
+
+class Scope {
+public:
+    explicit Scope(const char* name) : name_(Enabled() ? name : nullptr), start_ns_(name_ ? NowNs() : 0) {}
+    ~Scope() {
+        if (name_) {
+            Record(name_, start_ns_, NowNs());
+        }
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name_;
+    std::int64_t start_ns_;
+};
+
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) profiler::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
@@ -0,0 +1,338 @@
+#include "projectiles.hpp"
+#include "collision.hpp"
+#include "state_hash.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr float kAcornGravity = 260.0f;
+constexpr int kAcornSize = 12;
+constexpr float kAcornHalfSize = kAcornSize * 0.5f;
+constexpr float kAcornSpinFps = 12.0f;
+constexpr float kKillBottom = 900.0f;
+constexpr float kKnockbackSpeed = 180.0f;
+
+// The kernels below take restrict-qualified arrays so an optimised build can vectorise each loop.
+void IntegrateAcorns(float* __restrict x, float* __restrict y, float* __restrict vy,
+                     const float* __restrict vx, float* __restrict prev_x, float* __restrict prev_y,
+                     int n, float dt) {
+    for (int i = 0; i < n; ++i) {
+        prev_x[i] = x[i];
+        prev_y[i] = y[i];
+        vy[i] += kAcornGravity * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+    }
+}
+
+void FlagOutOfBounds(const float* __restrict x, const float* __restrict y,
+                     unsigned char* __restrict dead, int n, float left, float right) {
+    for (int i = 0; i < n; ++i) {
+        dead[i] = static_cast<unsigned char>((y[i] > kKillBottom) | (x[i] < left) | (x[i] > right));
+    }
+}
+
+// Where the player started the tick, grown by half an acorn: an acorn centre inside it
+// means the two boxes overlap. Sweeping an acorn's motion relative to the player against
+// it catches acorns that would pass through the player between two ticks.
+SDL_FRect PlayerStartBox(const SDL_Rect& player_rect, SDL_FPoint player_motion) {
+    return SDL_FRect{static_cast<float>(player_rect.x) - player_motion.x - kAcornHalfSize,
+                     static_cast<float>(player_rect.y) - player_motion.y - kAcornHalfSize,
+                     static_cast<float>(player_rect.w) + kAcornSize,
+                     static_cast<float>(player_rect.h) + kAcornSize};
+}
+
+// Flags acorns whose path this tick, from (prev_x, prev_y) to (x, y) less the player's own
+// motion (dx, dy), has bounds overlapping the box; only those need the exact sweep.
+bool FlagNearPath(const float* __restrict x, const float* __restrict y, const float* __restrict prev_x,
+                  const float* __restrict prev_y, unsigned char* __restrict hit, int n, float dx, float dy,
+                  float left, float right, float top, float bottom) {
+    unsigned char any_hit = 0;
+    for (int i = 0; i < n; ++i) {
+        const float end_x = x[i] - dx;
+        const float end_y = y[i] - dy;
+        const float min_x = std::min(prev_x[i], end_x);
+        const float max_x = std::max(prev_x[i], end_x);
+        const float min_y = std::min(prev_y[i], end_y);
+        const float max_y = std::max(prev_y[i], end_y);
+        hit[i] = static_cast<unsigned char>((max_x > left) & (min_x < right) & (max_y > top) & (min_y < bottom));
+        any_hit |= hit[i];
+    }
+    return any_hit != 0;
+}
+}
+
+AcornPool::AcornPool() {
+    for (int i = 0; i < kCapacity; ++i) {
+        ids_[i] = static_cast<std::uint32_t>(i);
+        slot_of_id_[i] = i;
+    }
+}
+
+void AcornPool::SetTextures(TextureHandle acorn_textures) {
+    acorn_textures_ = std::move(acorn_textures);
+}
+
+void AcornPool::SetBounds(float left, float right) {
+    kill_left_ = left;
+    kill_right_ = right;
+}
+
+bool AcornPool::Spawn(float x, float y, float vx, float vy) {
+    if (count_ >= kCapacity) {
+        return false;
+    }
+
+    const int i = count_++;
+    x_[i] = x;
+    y_[i] = y;
+    vx_[i] = vx;
+    vy_[i] = vy;
+    prev_x_[i] = x;
+    prev_y_[i] = y;
+    // ids_[i] is the next free id already.
+    return true;
+}
+
+void AcornPool::RemoveAt(int index) {
+    const int last = --count_;
+    x_[index] = x_[last];
+    y_[index] = y_[last];
+    vx_[index] = vx_[last];
+    vy_[index] = vy_[last];
+    prev_x_[index] = prev_x_[last];
+    prev_y_[index] = prev_y_[last];
+    flags_[index] = flags_[last];
+    std::swap(ids_[index], ids_[last]);
+    slot_of_id_[ids_[index]] = index;
+    slot_of_id_[ids_[last]] = last;
+}
+
+void AcornPool::RemoveFlagged() {
+    for (int i = count_ - 1; i >= 0; --i) {
+        if (flags_[i]) {
+            RemoveAt(i);
+        }
+    }
+}
+
+void AcornPool::SpawnQueued() {
+    queued_shots_.ForEachInOrder([this](const Shot& shot) { Spawn(shot.x, shot.y, shot.vx, shot.vy); });
+    queued_shots_.Reset(0);
+}
+
+void AcornPool::Update(float dt, JobSystem* jobs) {
+    const float left = kill_left_;
+    const float right = kill_right_;
+    auto integrate = [this, dt, left, right](int, int begin, int end) {
+        const int n = end - begin;
+        IntegrateAcorns(x_.data() + begin, y_.data() + begin, vy_.data() + begin, vx_.data() + begin,
+                        prev_x_.data() + begin, prev_y_.data() + begin, n, dt);
+        FlagOutOfBounds(x_.data() + begin, y_.data() + begin, flags_.data() + begin, n, left, right);
+    };
+    if (jobs) {
+        jobs->ParallelFor(count_, kGrain, integrate);
+    } else {
+        integrate(0, 0, count_);
+    }
+    // Removal reorders the arrays, so it stays serial.
+    RemoveFlagged();
+}
+
+bool AcornPool::PathHits(int index, const SDL_FRect& box, SDL_FPoint player_motion) const {
+    SweepHit hit;
+    const SDL_FPoint path{x_[index] - prev_x_[index] - player_motion.x, y_[index] - prev_y_[index] - player_motion.y};
+    return RayVsBox(SDL_FPoint{prev_x_[index], prev_y_[index]}, path, box, &hit);
+}
+
+bool AcornPool::CheckHitPlayer(const SDL_Rect& player_rect, SDL_FPoint player_motion, float* out_knockback_x,
+                               JobSystem* jobs) {
+    const SDL_FRect box = PlayerStartBox(player_rect, player_motion);
+
+    // Each chunk records its own first hit; the lowest across chunks is the serial answer.
+    auto flag_hits = [&](int chunk, int begin, int end) {
+        first_hit_[chunk] = -1;
+        if (!FlagNearPath(x_.data() + begin, y_.data() + begin, prev_x_.data() + begin, prev_y_.data() + begin,
+                          flags_.data() + begin, end - begin, player_motion.x, player_motion.y, box.x,
+                          box.x + box.w, box.y, box.y + box.h)) {
+            return;
+        }
+        for (int i = begin; i < end; ++i) {
+            if (!flags_[i]) {
+                continue;
+            }
+            if (!PathHits(i, box, player_motion)) {
+                flags_[i] = 0;
+            } else if (first_hit_[chunk] < 0) {
+                first_hit_[chunk] = i;
+            }
+        }
+    };
+    const int chunks = JobSystem::ChunkCount(count_, kGrain);
+    if (jobs) {
+        jobs->ParallelFor(count_, kGrain, flag_hits);
+    } else {
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            flag_hits(chunk, chunk * kGrain, std::min((chunk + 1) * kGrain, count_));
+        }
+    }
+
+    int first_hit = -1;
+    for (int chunk = 0; chunk < chunks && first_hit < 0; ++chunk) {
+        first_hit = first_hit_[chunk];
+    }
+    if (first_hit < 0) {
+        return false;
+    }
+    ConsumeHits(first_hit, out_knockback_x);
+    return true;
+}
+
+bool AcornPool::CheckHitPlayer(const std::uint32_t* candidates, int candidate_count, const SDL_Rect& player_rect,
+                               SDL_FPoint player_motion, float* out_knockback_x) {
+    const SDL_FRect box = PlayerStartBox(player_rect, player_motion);
+    // The lowest slot hit is the one a scan over every acorn would have found first.
+    int first_hit = -1;
+    for (int c = 0; c < candidate_count; ++c) {
+        const int i = slot_of_id_[candidates[c]];
+        if (PathHits(i, box, player_motion)) {
+            flags_[i] = 1;
+            first_hit = first_hit < 0 ? i : std::min(first_hit, i);
+        }
+    }
+    if (first_hit < 0) {
+        return false;
+    }
+    ConsumeHits(first_hit, out_knockback_x);
+    return true;
+}
+
+void AcornPool::ConsumeHits(int first_hit, float* out_knockback_x) {
+    if (out_knockback_x) {
+        *out_knockback_x = vx_[first_hit] >= 0.0f ? kKnockbackSpeed : -kKnockbackSpeed;
+    }
+    RemoveFlagged();
+}
+
+void AcornPool::AddColliders(Broadphase* broadphase) const {
+    for (int i = 0; i < count_; ++i) {
+        const float left = std::min(prev_x_[i], x_[i]) - kAcornHalfSize;
+        const float top = std::min(prev_y_[i], y_[i]) - kAcornHalfSize;
+        const float right = std::max(prev_x_[i], x_[i]) + kAcornHalfSize;
+        const float bottom = std::max(prev_y_[i], y_[i]) + kAcornHalfSize;
+        broadphase->Add(BroadphaseLayer::kProjectile, ids_[i],
+                        SDL_FRect{left, top, right - left, bottom - top});
+    }
+}
+
+std::uint64_t AcornPool::StateHash() const {
+    StateHasher hasher;
+    for (int i = 0; i < count_; ++i) {
+        hasher.Add(x_[i]);
+        hasher.Add(y_[i]);
+        hasher.Add(vx_[i]);
+        hasher.Add(vy_[i]);
+    }
+    return hasher.Value();
+}
+
+void AcornPool::Save(SnapshotWriter* out) const {
+    const std::size_t count = static_cast<std::size_t>(count_);
+    out->WriteArray(x_.data(), count);
+    out->WriteArray(y_.data(), count);
+    out->WriteArray(vx_.data(), count);
+    out->WriteArray(vy_.data(), count);
+    out->WriteArray(prev_x_.data(), count);
+    out->WriteArray(prev_y_.data(), count);
+    out->WriteArray(ids_.data(), count);
+}
+
+bool AcornPool::Restore(SnapshotReader* in) {
+    // Every array repeats the count; the first one sets it.
+    std::uint32_t count = 0;
+    SnapshotReader peek = *in;
+    if (!peek.Read(&count) || count > kCapacity ||
+        !in->ReadArray(x_.data(), count) || !in->ReadArray(y_.data(), count) ||
+        !in->ReadArray(vx_.data(), count) || !in->ReadArray(vy_.data(), count) ||
+        !in->ReadArray(prev_x_.data(), count) || !in->ReadArray(prev_y_.data(), count) ||
+        !in->ReadArray(ids_.data(), count)) {
+        count_ = 0;
+        RebuildFreeIds();
+        return false;
+    }
+    count_ = static_cast<int>(count);
+    // Live ids must be distinct and in range, or the permutation cannot be rebuilt.
+    std::fill(flags_.begin(), flags_.end(), 0);
+    bool ids_ok = true;
+    for (int i = 0; i < count_ && ids_ok; ++i) {
+        ids_ok = ids_[i] < static_cast<std::uint32_t>(kCapacity) && !flags_[ids_[i]];
+        if (ids_ok) {
+            flags_[ids_[i]] = 1;
+        }
+    }
+    std::fill(flags_.begin(), flags_.end(), 0);
+    if (!ids_ok) {
+        count_ = 0;
+    }
+    RebuildFreeIds();
+    return ids_ok;
+}
+
+void AcornPool::RebuildFreeIds() {
+    // flags_ is scratch here and clear again on return.
+    for (int i = 0; i < count_; ++i) {
+        flags_[ids_[i]] = 1;
+    }
+    int next = count_;
+    for (int id = 0; id < kCapacity; ++id) {
+        if (!flags_[id]) {
+            ids_[next++] = static_cast<std::uint32_t>(id);
+        }
+        flags_[id] = 0;
+    }
+    for (int i = 0; i < kCapacity; ++i) {
+        slot_of_id_[ids_[i]] = i;
+    }
+}
+
+int AcornPool::Render(SpriteBatch* batch, const SDL_Rect& view, float camera_x, float alpha) const {
+    const SpriteFrame* acorn_frame = nullptr;
+    if (HasFrames(acorn_textures_)) {
+        const Uint32 ticks = SDL_GetTicks();
+        const std::size_t frame_count = acorn_textures_->frames.size();
+        const std::size_t frame_index =
+            static_cast<std::size_t>((ticks * kAcornSpinFps) / 1000.0f) % frame_count;
+        acorn_frame = &acorn_textures_->frames[frame_index];
+    }
+
+    const float half = kAcornSize * 0.5f;
+    const float view_left = static_cast<float>(view.x) - half;
+    const float view_right = static_cast<float>(view.x + view.w) + half;
+    const float view_top = static_cast<float>(view.y) - half;
+    const float view_bottom = static_cast<float>(view.y + view.h) + half;
+
+    int drawn = 0;
+    for (int i = 0; i < count_; ++i) {
+        const float x = prev_x_[i] + (x_[i] - prev_x_[i]) * alpha;
+        const float y = prev_y_[i] + (y_[i] - prev_y_[i]) * alpha;
+        if (x < view_left || x > view_right || y < view_top || y > view_bottom) {
+            continue;
+        }
+
+        SDL_Rect acorn_rect{
+            static_cast<int>(x - camera_x) - (kAcornSize / 2),
+            static_cast<int>(y) - (kAcornSize / 2),
+            kAcornSize,
+            kAcornSize
+        };
+
+        if (acorn_frame && acorn_frame->texture) {
+            batch->Draw(*acorn_frame, acorn_rect);
+        } else {
+            batch->FillRect(acorn_rect, SDL_Color{122, 75, 34, 255});
+        }
+        ++drawn;
+    }
+    return drawn;
+}
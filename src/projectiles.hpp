@@ -0,0 +1,104 @@
+#pragma once
+
+#include <SDL.h>
+#include <array>
+#include <cstdint>
+#include "broadphase.hpp"
+#include "job_system.hpp"
+#include "snapshot.hpp"
+#include "sprite_batch.hpp"
+#include "texture_set.hpp"
+
+// Every live acorn in the level, stored as parallel arrays so integration and the player
+// hit test are straight loops over floats the compiler can vectorise. Capacity is fixed;
+// dead acorns are swap-removed, so the live range is always [0, Count()). Each acorn also
+// has an id below kCapacity that, unlike its slot, stays the same while it lives.
+class AcornPool {
+public:
+    static constexpr int kCapacity = 4096;
+
+    AcornPool();
+
+    void SetTextures(TextureHandle acorn_textures);
+    // Acorns leaving [left, right] are dropped, like those falling off the bottom.
+    void SetBounds(float left, float right);
+
+    // Returns false (and drops the shot) when the pool is full.
+    bool Spawn(float x, float y, float vx, float vy);
+    // Shots fired from inside a ParallelFor: each chunk queues into its own list and
+    // SpawnQueued adds them in chunk order, the order a serial loop would have used.
+    // A chunk queues at most max_per_chunk shots.
+    void BeginQueuedShots(int chunks, int max_per_chunk) {
+        queued_shots_.Reset(chunks, static_cast<std::size_t>(max_per_chunk));
+    }
+    void QueueShot(int chunk, float x, float y, float vx, float vy) {
+        queued_shots_[chunk].push_back(Shot{x, y, vx, vy});
+    }
+    void SpawnQueued();
+
+    // With jobs, ranges of acorns are processed in parallel; the outcome is bit-identical.
+    void Update(float dt, JobSystem* jobs = nullptr);
+    // Consumes every acorn that touched the player during this tick, given where the player
+    // is now and how far it moved this tick; knockback follows the first one hit. Paths are
+    // swept, so a fast acorn or a long tick cannot skip through the player.
+    bool CheckHitPlayer(const SDL_Rect& player_rect, SDL_FPoint player_motion, float* out_knockback_x,
+                        JobSystem* jobs = nullptr);
+    // The same, testing only the acorns in candidates (ids paired with the player by the
+    // broadphase) instead of all of them.
+    bool CheckHitPlayer(const std::uint32_t* candidates, int candidate_count, const SDL_Rect& player_rect,
+                        SDL_FPoint player_motion, float* out_knockback_x);
+    // Adds each acorn's path this tick, grown by half an acorn, as kProjectile keyed by id,
+    // so the broadphase can carry an acorn's place in its order over from the tick before.
+    void AddColliders(Broadphase* broadphase) const;
+    // Draws the acorns that overlap view (world space) and returns how many that was.
+    int Render(SpriteBatch* batch, const SDL_Rect& view, float camera_x, float alpha) const;
+
+    int Count() const { return count_; }
+    void Clear() { count_ = 0; }
+    // Hash of every live acorn's position and velocity bits, for determinism checks.
+    std::uint64_t StateHash() const;
+    // The live acorns and their ids only; bounds and textures are not saved. A pool that
+    // fails to restore is left empty.
+    void Save(SnapshotWriter* out) const;
+    bool Restore(SnapshotReader* in);
+
+private:
+    struct Shot {
+        float x;
+        float y;
+        float vx;
+        float vy;
+    };
+
+    static constexpr int kGrain = 1024;  // acorns per parallel chunk
+
+    // Whether acorn index's path this tick, relative to the player, enters box.
+    bool PathHits(int index, const SDL_FRect& box, SDL_FPoint player_motion) const;
+    // Knockback from the first acorn hit, then removes every flagged one.
+    void ConsumeHits(int first_hit, float* out_knockback_x);
+    void RemoveAt(int index);
+    // Swap-removes every acorn whose flag is set, walking backwards so moved-in
+    // acorns have already been examined.
+    void RemoveFlagged();
+    // Hands out the ids no live acorn holds, lowest first, to the free slots.
+    void RebuildFreeIds();
+
+    alignas(32) std::array<float, kCapacity> x_{};
+    alignas(32) std::array<float, kCapacity> y_{};
+    alignas(32) std::array<float, kCapacity> vx_{};
+    alignas(32) std::array<float, kCapacity> vy_{};
+    alignas(32) std::array<float, kCapacity> prev_x_{};
+    alignas(32) std::array<float, kCapacity> prev_y_{};
+    // Clear between calls: Update and the hit tests remove every acorn they flag.
+    alignas(32) std::array<unsigned char, kCapacity> flags_{};
+    // A permutation of [0, kCapacity): the ids of the live acorns, then the free ids in the
+    // order Spawn hands them out. Swap-removal swaps ids, so both halves stay intact.
+    std::array<std::uint32_t, kCapacity> ids_{};
+    std::array<int, kCapacity> slot_of_id_{};
+    std::array<int, kCapacity / kGrain> first_hit_{};  // per chunk, lowest index hit or -1
+    ChunkedOutput<Shot> queued_shots_{};
+    int count_ = 0;
+    float kill_left_ = -400.0f;
+    float kill_right_ = 6000.0f;
+    TextureHandle acorn_textures_{};
+};
@@ -0,0 +1,86 @@
+#include "registry.hpp"
+
+Entity Registry::Create() {
+    if (!free_ids_.empty()) {
+        const Entity entity = free_ids_.back();
+        free_ids_.pop_back();
+        return entity;
+    }
+    return next_id_++;
+}
+
+void Registry::Destroy(Entity entity) {
+    transforms.Remove(entity);
+    velocities.Remove(entity);
+    colliders.Remove(entity);
+    animations.Remove(entity);
+    shooters.Remove(entity);
+    chunk_members.Remove(entity);
+    free_ids_.push_back(entity);
+}
+
+void Registry::Clear() {
+    transforms.Clear();
+    velocities.Clear();
+    colliders.Clear();
+    animations.Clear();
+    shooters.Clear();
+    chunk_members.Clear();
+    next_id_ = 0;
+    free_ids_.clear();
+}
+
+void Registry::Reserve(std::size_t entities) {
+    transforms.Reserve(entities);
+    velocities.Reserve(entities);
+    colliders.Reserve(entities);
+    animations.Reserve(entities);
+    shooters.Reserve(entities);
+    chunk_members.Reserve(entities);
+    free_ids_.reserve(entities);
+}
+
+void Registry::Save(SnapshotWriter* out) const {
+    out->Write(next_id_);
+    out->WriteArray(free_ids_);
+    transforms.Save(out);
+    velocities.Save(out);
+    colliders.Save(out);
+    animations.Save(out);
+    shooters.Save(out);
+    chunk_members.Save(out);
+}
+
+bool Registry::Restore(SnapshotReader* in) {
+    if (!in->Read(&next_id_) || !in->ReadArray(&free_ids_, next_id_)) {
+        return false;
+    }
+    return transforms.Restore(in, next_id_) && velocities.Restore(in, next_id_) &&
+           colliders.Restore(in, next_id_) && animations.Restore(in, next_id_) &&
+           shooters.Restore(in, next_id_) && chunk_members.Restore(in, next_id_);
+}
+
+void StorePreviousTransforms(Registry* registry) {
+    for (Transform& t : registry->transforms.Data()) {
+        t.prev_x = t.x;
+        t.prev_y = t.y;
+    }
+}
+
+namespace {
+template <typename T>
+void HashStore(const ComponentStore<T>& store, StateHasher* hasher) {
+    hasher->Add(store.Size());
+    hasher->AddBytes(store.Entities().data(), store.Entities().size() * sizeof(Entity));
+    hasher->AddBytes(store.Data().data(), store.Data().size() * sizeof(T));
+}
+}
+
+void HashState(const Registry& registry, StateHasher* hasher) {
+    HashStore(registry.transforms, hasher);
+    HashStore(registry.velocities, hasher);
+    HashStore(registry.colliders, hasher);
+    HashStore(registry.animations, hasher);
+    HashStore(registry.shooters, hasher);
+    HashStore(registry.chunk_members, hasher);
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "snapshot.hpp"
+#include "state_hash.hpp"
+
+// Entities are plain ids; their state lives in one dense array per component type, so a
+// system walks only the components it reads. Ids are recycled after Destroy, so do not
+// hold one past the entity's lifetime.
+using Entity = std::uint32_t;
+constexpr Entity kNoEntity = ~Entity{0};
+
+// (x, y) is the bottom-left of the body; prev_* is the pose at the start of the tick and is
+// what Render interpolates from.
+struct Transform {
+    float x = 0.0f;
+    float y = 0.0f;
+    float prev_x = 0.0f;
+    float prev_y = 0.0f;
+};
+
+struct Velocity {
+    float vx = 0.0f;
+    float vy = 0.0f;
+};
+
+// Body rect extends width right and height up from the transform.
+struct Collider {
+    int width = 0;
+    int height = 0;
+};
+
+// Clips live in an AnimationLibrary (animation.hpp); ids index it.
+using ClipId = std::uint16_t;
+constexpr ClipId kNoClip = 0xffff;
+
+// Playback position in a clip; AdvanceAnimations moves it on. kNoClip shows no animation.
+struct AnimationState {
+    ClipId clip = kNoClip;
+    std::uint16_t frame = 0;
+    float time = 0.0f;
+};
+
+// Squirrel behaviour: fires at the player on a timer, dies after hits_remaining hits.
+struct ShooterAI {
+    float shot_timer = 0.0f;
+    float hurt_cooldown = 0.0f;
+    int hits_remaining = 0;
+    // Time that has passed without this squirrel being ticked (it was far from the view
+    // and waiting for its slice); the next tick catches up on it.
+    float idle_time = 0.0f;
+};
+
+// Set on entities a level chunk spawned; they go when the chunk is unloaded.
+struct ChunkMember {
+    int chunk = 0;
+};
+
+// Sparse set: Get is an O(1) lookup through sparse_, iteration runs over the packed
+// arrays. Remove swaps the last element into the hole, so it reorders the store.
+template <typename T>
+class ComponentStore {
+public:
+    T& Add(Entity entity, const T& value = T{}) {
+        if (entity >= sparse_.size()) {
+            sparse_.resize(entity + 1, kAbsent);
+        }
+        if (sparse_[entity] != kAbsent) {
+            return dense_[sparse_[entity]] = value;
+        }
+        sparse_[entity] = static_cast<std::uint32_t>(dense_.size());
+        entities_.push_back(entity);
+        dense_.push_back(value);
+        return dense_.back();
+    }
+
+    void Remove(Entity entity) {
+        if (!Has(entity)) {
+            return;
+        }
+        const std::uint32_t index = sparse_[entity];
+        const Entity moved = entities_.back();
+        dense_[index] = dense_.back();
+        entities_[index] = moved;
+        sparse_[moved] = index;
+        dense_.pop_back();
+        entities_.pop_back();
+        sparse_[entity] = kAbsent;
+    }
+
+    bool Has(Entity entity) const { return entity < sparse_.size() && sparse_[entity] != kAbsent; }
+    T& Get(Entity entity) { return dense_[sparse_[entity]]; }
+    const T& Get(Entity entity) const { return dense_[sparse_[entity]]; }
+    T* Find(Entity entity) { return Has(entity) ? &dense_[sparse_[entity]] : nullptr; }
+
+    std::size_t Size() const { return dense_.size(); }
+    // Room for entity ids below capacity, so Add does not allocate for them.
+    void Reserve(std::size_t capacity) {
+        dense_.reserve(capacity);
+        entities_.reserve(capacity);
+        sparse_.reserve(capacity);
+    }
+    // Packed components and, at the same index, the entity owning each.
+    std::vector<T>& Data() { return dense_; }
+    const std::vector<T>& Data() const { return dense_; }
+    const std::vector<Entity>& Entities() const { return entities_; }
+
+    void Clear() {
+        dense_.clear();
+        entities_.clear();
+        sparse_.clear();
+    }
+
+    void Save(SnapshotWriter* out) const {
+        out->WriteArray(dense_);
+        out->WriteArray(entities_);
+        out->WriteArray(sparse_);
+    }
+    // Fails on arrays that do not form a valid sparse set for ids below id_limit.
+    bool Restore(SnapshotReader* in, Entity id_limit) {
+        if (!in->ReadArray(&dense_, id_limit) || !in->ReadArray(&entities_, id_limit) ||
+            !in->ReadArray(&sparse_, id_limit) || entities_.size() != dense_.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < entities_.size(); ++i) {
+            if (entities_[i] >= sparse_.size() || sparse_[entities_[i]] != i) {
+                return false;
+            }
+        }
+        for (Entity entity = 0; entity < sparse_.size(); ++entity) {
+            if (sparse_[entity] != kAbsent && (sparse_[entity] >= entities_.size() ||
+                                               entities_[sparse_[entity]] != entity)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::uint32_t kAbsent = ~std::uint32_t{0};
+
+    std::vector<T> dense_{};
+    std::vector<Entity> entities_{};
+    std::vector<std::uint32_t> sparse_{};
+};
+
+class Registry {
+public:
+    Entity Create();
+    // Drops every component of entity and makes its id available again.
+    void Destroy(Entity entity);
+    void Clear();
+    // Sizes every store for this many live entities up front: while ids stay below it,
+    // spawning never allocates.
+    void Reserve(std::size_t entities);
+    std::size_t Alive() const { return next_id_ - free_ids_.size(); }
+
+    // Every id and component, stores reusing their storage on Restore. A registry that
+    // fails to restore is left inconsistent and must be restored again or cleared.
+    void Save(SnapshotWriter* out) const;
+    bool Restore(SnapshotReader* in);
+
+    ComponentStore<Transform> transforms{};
+    ComponentStore<Velocity> velocities{};
+    ComponentStore<Collider> colliders{};
+    ComponentStore<AnimationState> animations{};
+    ComponentStore<ShooterAI> shooters{};
+    ComponentStore<ChunkMember> chunk_members{};
+
+private:
+    Entity next_id_ = 0;
+    std::vector<Entity> free_ids_{};
+};
+
+// Systems shared by every kind of entity; AdvanceAnimations is in animation.hpp.
+void StorePreviousTransforms(Registry* registry);
+// Feeds every live entity id and component, in storage order, into hasher.
+void HashState(const Registry& registry, StateHasher* hasher);
@@ -0,0 +1,64 @@
+#include "snapshot.hpp"
+#include "state_hash.hpp"
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace {
+// Far beyond any real level; a header claiming more is damaged.
+constexpr std::uint64_t kMaxPayloadBytes = 64ull << 20;
+
+std::uint64_t PayloadHash(const std::vector<std::uint8_t>& bytes) {
+    StateHasher hasher;
+    hasher.AddBytes(bytes.data(), bytes.size());
+    return hasher.Value();
+}
+}
+
+bool SaveSnapshotFile(const std::string& path, const GameSnapshot& snapshot) {
+    SnapshotFileHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.version = kSnapshotVersion;
+    header.tick = snapshot.tick;
+    header.checksum = snapshot.checksum;
+    header.payload_size = snapshot.bytes.size();
+    header.payload_hash = PayloadHash(snapshot.bytes);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Cannot write snapshot " << path << "\n";
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(snapshot.bytes.data()),
+              static_cast<std::streamsize>(snapshot.bytes.size()));
+    return static_cast<bool>(out);
+}
+
+bool LoadSnapshotFile(const std::string& path, GameSnapshot* snapshot) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot open snapshot " << path << "\n";
+        return false;
+    }
+
+    SnapshotFileHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0 ||
+        header.version != kSnapshotVersion || header.payload_size > kMaxPayloadBytes) {
+        std::cerr << "Snapshot " << path << " has an unsupported or corrupt header\n";
+        return false;
+    }
+
+    std::vector<std::uint8_t> bytes(static_cast<std::size_t>(header.payload_size));
+    in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!in || PayloadHash(bytes) != header.payload_hash) {
+        std::cerr << "Snapshot " << path << " is truncated or damaged\n";
+        return false;
+    }
+
+    snapshot->tick = header.tick;
+    snapshot->checksum = header.checksum;
+    snapshot->bytes = std::move(bytes);
+    return true;
+}
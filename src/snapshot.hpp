@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Simulation state as a flat run of plain values: everything written is trivially
+// copyable, so saving and restoring are memcpys, and the same bytes go to disk. Textures,
+// sounds and other handles are never part of it; they stay with the objects that own them.
+//
+// On-disk layout of a snapshot file:
+//
+//   SnapshotFileHeader
+//   payload          GameSnapshot::bytes, as Game::SaveSnapshot wrote them
+//
+// Bump kSnapshotVersion whenever a saved type or the order things are written in changes.
+constexpr char kSnapshotMagic[4] = {'A', 'P', 'S', 'S'};
+constexpr std::uint32_t kSnapshotVersion = 2;
+
+struct SnapshotFileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t tick;
+    std::uint32_t reserved;  // zero
+    std::uint64_t checksum;       // Game::StateChecksum() when the snapshot was taken
+    std::uint64_t payload_size;
+    std::uint64_t payload_hash;   // FNV-1a of the payload, to catch a damaged file
+};
+
+// One saved moment of the simulation. Storage is reused, so saving into the same snapshot
+// again does not allocate once it has held a state as large.
+struct GameSnapshot {
+    std::uint32_t tick = 0;
+    std::uint64_t checksum = 0;
+    std::vector<std::uint8_t> bytes{};
+};
+
+bool SaveSnapshotFile(const std::string& path, const GameSnapshot& snapshot);
+bool LoadSnapshotFile(const std::string& path, GameSnapshot* snapshot);
+
+// Appends values to a snapshot's bytes.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::vector<std::uint8_t>* out) : out_(out) { out_->clear(); }
+
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot plain values only");
+        Append(&value, sizeof(T));
+    }
+
+    // A count, then the elements.
+    template <typename T>
+    void WriteArray(const T* data, std::size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot plain values only");
+        Write(static_cast<std::uint32_t>(count));
+        Append(data, count * sizeof(T));
+    }
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        WriteArray(values.data(), values.size());
+    }
+
+private:
+    void Append(const void* data, std::size_t size) {
+        const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+        out_->insert(out_->end(), bytes, bytes + size);
+    }
+
+    std::vector<std::uint8_t>* out_;
+};
+
+// Reads values back in the order they were written. Every read is bounds-checked; after the
+// first one that fails, all further reads fail too.
+class SnapshotReader {
+public:
+    SnapshotReader(const std::uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    bool Read(T* value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot plain values only");
+        return Take(value, sizeof(T));
+    }
+
+    // Reads a WriteArray of at most max_count elements; vectors keep their capacity.
+    template <typename T>
+    bool ReadArray(std::vector<T>* values, std::size_t max_count = ~std::size_t{0}) {
+        std::uint32_t count = 0;
+        if (!Read(&count) || count > max_count || count > (size_ - pos_) / sizeof(T)) {
+            ok_ = false;
+            return false;
+        }
+        values->resize(count);
+        return Take(values->data(), count * sizeof(T));
+    }
+    // Reads a WriteArray into exactly count elements at data.
+    template <typename T>
+    bool ReadArray(T* data, std::size_t count) {
+        std::uint32_t stored = 0;
+        if (!Read(&stored) || stored != count) {
+            ok_ = false;
+            return false;
+        }
+        return Take(data, count * sizeof(T));
+    }
+
+    bool Ok() const { return ok_; }
+    // Whether every byte was read and nothing failed.
+    bool Done() const { return ok_ && pos_ == size_; }
+
+private:
+    bool Take(void* out, std::size_t size) {
+        if (!ok_ || size > size_ - pos_) {
+            ok_ = false;
+            return false;
+        }
+        if (size > 0) {
+            std::memcpy(out, data_ + pos_, size);
+        }
+        pos_ += size;
+        return true;
+    }
+
+    const std::uint8_t* data_;
+    std::size_t size_;
+    std::size_t pos_ = 0;
+    bool ok_ = true;
+};
@@ -0,0 +1,71 @@
+#include "spatial_grid.hpp"
+
+#include <climits>
+
+void StaticGrid::Build(const SDL_Rect* rects, std::size_t count, int cell_size) {
+    Clear();
+    rects_.assign(rects, rects + count);
+    cell_size_ = std::max(cell_size, 1);
+    if (rects_.empty()) {
+        return;
+    }
+
+    int min_x = INT_MAX;
+    int min_y = INT_MAX;
+    int max_x = INT_MIN;
+    int max_y = INT_MIN;
+    for (const SDL_Rect& r : rects_) {
+        min_x = std::min(min_x, r.x);
+        min_y = std::min(min_y, r.y);
+        max_x = std::max(max_x, r.x + std::max(r.w, 1));
+        max_y = std::max(max_y, r.y + std::max(r.h, 1));
+    }
+
+    origin_x_ = min_x;
+    origin_y_ = min_y;
+    cols_ = (max_x - min_x + cell_size_ - 1) / cell_size_;
+    rows_ = (max_y - min_y + cell_size_ - 1) / cell_size_;
+    cols_ = std::max(cols_, 1);
+    rows_ = std::max(rows_, 1);
+
+    // Two passes (count, then fill) give one flat array with per-cell offsets.
+    cell_start_.assign(static_cast<std::size_t>(cols_) * rows_ + 1, 0);
+    auto for_each_cell = [&](const SDL_Rect& r, auto&& fn) {
+        const int cx0 = CellX(r.x);
+        const int cx1 = CellX(r.x + std::max(r.w, 1) - 1);
+        const int cy0 = CellY(r.y);
+        const int cy1 = CellY(r.y + std::max(r.h, 1) - 1);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                fn(cy * cols_ + cx);
+            }
+        }
+    };
+
+    for (const SDL_Rect& r : rects_) {
+        for_each_cell(r, [&](int cell) { ++cell_start_[cell + 1]; });
+    }
+    for (std::size_t i = 1; i < cell_start_.size(); ++i) {
+        cell_start_[i] += cell_start_[i - 1];
+    }
+
+    cell_items_.resize(cell_start_.back());
+    cursor_.assign(cell_start_.begin(), cell_start_.end() - 1);
+    for (int index = 0; index < static_cast<int>(rects_.size()); ++index) {
+        for_each_cell(rects_[index], [&](int cell) { cell_items_[cursor_[cell]++] = index; });
+    }
+}
+
+void StaticGrid::Clear() {
+    rects_.clear();
+    cell_start_.clear();
+    cell_items_.clear();
+    origin_x_ = 0;
+    origin_y_ = 0;
+    cols_ = 0;
+    rows_ = 0;
+}
+
+void StaticGrid::Query(const SDL_Rect& area, std::vector<int>* out) const {
+    Query(area, [out](int index) { out->push_back(index); });
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <SDL.h>
+#include <algorithm>
+#include <vector>
+
+// Uniform grid over static rects (platforms, scenery). Built once, then queried many
+// times per tick; a query only visits the cells its area touches, so its cost depends on
+// local density rather than on how many rects the level holds.
+class StaticGrid {
+public:
+    void Build(const std::vector<SDL_Rect>& rects, int cell_size = 128) {
+        Build(rects.data(), rects.size(), cell_size);
+    }
+    // Storage is reused, so rebuilding at a size seen before does not allocate.
+    void Build(const SDL_Rect* rects, std::size_t count, int cell_size = 128);
+    void Clear();
+
+    // Calls fn(index) once for every rect that intersects area. Rects spanning several
+    // cells are reported only from the cell holding the top-left corner of the overlap,
+    // which keeps queries free of scratch state and safe to run from several threads.
+    template <typename Fn>
+    void Query(const SDL_Rect& area, Fn&& fn) const;
+
+    // Same as Query, appending indices to out.
+    void Query(const SDL_Rect& area, std::vector<int>* out) const;
+
+    bool Empty() const { return rects_.empty(); }
+    std::size_t Size() const { return rects_.size(); }
+    const SDL_Rect& Rect(int index) const { return rects_[index]; }
+
+private:
+    int CellX(int x) const { return std::clamp((x - origin_x_) / cell_size_, 0, cols_ - 1); }
+    int CellY(int y) const { return std::clamp((y - origin_y_) / cell_size_, 0, rows_ - 1); }
+
+    std::vector<SDL_Rect> rects_{};
+    std::vector<int> cell_start_{};  // cols_ * rows_ + 1 offsets into cell_items_
+    std::vector<int> cell_items_{};
+    std::vector<int> cursor_{};  // Build scratch, kept so rebuilding does not allocate
+    int cell_size_ = 128;
+    int origin_x_ = 0;
+    int origin_y_ = 0;
+    int cols_ = 0;
+    int rows_ = 0;
+};
+
+template <typename Fn>
+void StaticGrid::Query(const SDL_Rect& area, Fn&& fn) const {
+    if (rects_.empty() || area.w <= 0 || area.h <= 0) {
+        return;
+    }
+
+    const int area_right = area.x + area.w;
+    const int area_bottom = area.y + area.h;
+    const int cx0 = CellX(area.x);
+    const int cx1 = CellX(area_right - 1);
+    const int cy0 = CellY(area.y);
+    const int cy1 = CellY(area_bottom - 1);
+
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            const int cell = cy * cols_ + cx;
+            for (int i = cell_start_[cell]; i < cell_start_[cell + 1]; ++i) {
+                const int index = cell_items_[i];
+                const SDL_Rect& r = rects_[index];
+                if (r.x >= area_right || r.x + r.w <= area.x ||
+                    r.y >= area_bottom || r.y + r.h <= area.y) {
+                    continue;
+                }
+                if (CellX(std::max(r.x, area.x)) != cx || CellY(std::max(r.y, area.y)) != cy) {
+                    continue;
+                }
+                fn(index);
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "sprite_batch.hpp"
+
+#include <utility>
+
+namespace {
+// Quads one flush can hold before the vertex list has to grow mid-frame.
+constexpr std::size_t kReservedQuads = 2048;
+}
+
+void SpriteBatch::Begin(SDL_Renderer* renderer) {
+    if (vertices_.capacity() < kReservedQuads * 4) {
+        vertices_.reserve(kReservedQuads * 4);
+        indices_.reserve(kReservedQuads * 6);
+    }
+    renderer_ = renderer;
+    texture_ = nullptr;
+    has_texture_ = false;
+    vertices_.clear();
+    stats_ = RenderStats{};
+}
+
+void SpriteBatch::SetTexture(SDL_Texture* texture) {
+    if (has_texture_ && texture == texture_) {
+        return;
+    }
+
+    if (!vertices_.empty()) {
+        Flush();
+        ++stats_.texture_switches;
+    }
+    texture_ = texture;
+    has_texture_ = true;
+
+    int tex_w = 1;
+    int tex_h = 1;
+    if (texture) {
+        SDL_QueryTexture(texture, nullptr, nullptr, &tex_w, &tex_h);
+    }
+    inv_tex_w_ = 1.0f / static_cast<float>(tex_w);
+    inv_tex_h_ = 1.0f / static_cast<float>(tex_h);
+}
+
+void SpriteBatch::Draw(const SpriteFrame& frame, const SDL_Rect& dst, bool flip_x, SDL_Color tint) {
+    if (!frame.texture) {
+        return;
+    }
+
+    SetTexture(frame.texture);
+    float u0 = static_cast<float>(frame.src.x) * inv_tex_w_;
+    float u1 = static_cast<float>(frame.src.x + frame.src.w) * inv_tex_w_;
+    const float v0 = static_cast<float>(frame.src.y) * inv_tex_h_;
+    const float v1 = static_cast<float>(frame.src.y + frame.src.h) * inv_tex_h_;
+    if (flip_x) {
+        std::swap(u0, u1);
+    }
+    PushQuad(dst, u0, v0, u1, v1, tint);
+}
+
+void SpriteBatch::FillRect(const SDL_Rect& dst, SDL_Color color) {
+    if (white_.texture) {
+        Draw(white_, dst, false, color);
+        return;
+    }
+
+    SetTexture(nullptr);
+    PushQuad(dst, 0.0f, 0.0f, 0.0f, 0.0f, color);
+}
+
+void SpriteBatch::PushQuad(const SDL_Rect& dst, float u0, float v0, float u1, float v1, SDL_Color color) {
+    const float x0 = static_cast<float>(dst.x);
+    const float y0 = static_cast<float>(dst.y);
+    const float x1 = static_cast<float>(dst.x + dst.w);
+    const float y1 = static_cast<float>(dst.y + dst.h);
+
+    vertices_.push_back(SDL_Vertex{SDL_FPoint{x0, y0}, color, SDL_FPoint{u0, v0}});
+    vertices_.push_back(SDL_Vertex{SDL_FPoint{x1, y0}, color, SDL_FPoint{u1, v0}});
+    vertices_.push_back(SDL_Vertex{SDL_FPoint{x1, y1}, color, SDL_FPoint{u1, v1}});
+    vertices_.push_back(SDL_Vertex{SDL_FPoint{x0, y1}, color, SDL_FPoint{u0, v1}});
+    ++stats_.sprites;
+}
+
+void SpriteBatch::Flush() {
+    if (vertices_.empty() || !renderer_) {
+        vertices_.clear();
+        return;
+    }
+
+    // Two triangles per quad; the index pattern only ever grows.
+    const int quad_count = static_cast<int>(vertices_.size() / 4);
+    const int needed = quad_count * 6;
+    for (int quad = static_cast<int>(indices_.size() / 6); quad < quad_count; ++quad) {
+        const int base = quad * 4;
+        indices_.insert(indices_.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+    }
+
+    SDL_RenderGeometry(renderer_, texture_, vertices_.data(), static_cast<int>(vertices_.size()),
+                       indices_.data(), needed);
+    ++stats_.draw_calls;
+    vertices_.clear();
+}
+
+void SpriteBatch::End() {
+    Flush();
+}
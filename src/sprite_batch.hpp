@@ -0,0 +1,42 @@
+#pragma once
+
+#include <SDL.h>
+#include <vector>
+#include "texture_set.hpp"
+
+struct RenderStats {
+    int sprites = 0;           // quads submitted, i.e. what one RenderCopy each would cost
+    int draw_calls = 0;        // SDL_RenderGeometry calls actually issued
+    int texture_switches = 0;  // flushes caused by a change of texture
+};
+
+// Collects a frame's quads and submits them with SDL_RenderGeometry, one call per run of
+// quads that share a texture. Submission order is preserved, so layering is unchanged.
+class SpriteBatch {
+public:
+    void Begin(SDL_Renderer* renderer);
+    void Draw(const SpriteFrame& frame, const SDL_Rect& dst, bool flip_x = false,
+              SDL_Color tint = SDL_Color{255, 255, 255, 255});
+    // Solid quad; uses the atlas white texels when set so it stays in the current batch.
+    void FillRect(const SDL_Rect& dst, SDL_Color color);
+    void End();
+
+    void SetWhiteFrame(const SpriteFrame& white) { white_ = white; }
+    const RenderStats& Stats() const { return stats_; }
+
+private:
+    // Flushes the pending quads when texture differs from the current one.
+    void SetTexture(SDL_Texture* texture);
+    void PushQuad(const SDL_Rect& dst, float u0, float v0, float u1, float v1, SDL_Color color);
+    void Flush();
+
+    SDL_Renderer* renderer_ = nullptr;
+    SDL_Texture* texture_ = nullptr;
+    bool has_texture_ = false;
+    float inv_tex_w_ = 1.0f;
+    float inv_tex_h_ = 1.0f;
+    std::vector<SDL_Vertex> vertices_{};
+    std::vector<int> indices_{};
+    SpriteFrame white_{};
+    RenderStats stats_{};
+};
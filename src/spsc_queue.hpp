@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded ring for exactly one producer thread and one consumer thread. TryPush and TryPop
+// are wait-free and never allocate: each side owns one index, and reads the other's only
+// when its cached copy says the ring looks full (or empty).
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer only. Returns false, leaving the queue unchanged, when it is full.
+    bool TryPush(const T& value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == Capacity) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == Capacity) {
+                return false;
+            }
+        }
+        slots_[tail & kMask] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false when there is nothing to take.
+    bool TryPop(T* value) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        *value = slots_[head & kMask];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Slots that are free right now; more may free up at any moment.
+    std::size_t FreeSpace() {
+        head_cache_ = head_.load(std::memory_order_acquire);
+        return Capacity - (tail_.load(std::memory_order_relaxed) - head_cache_);
+    }
+
+    // Producer only. Copies as many of values as fit and returns how many that was.
+    std::size_t PushSome(const T* values, std::size_t count) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        count = std::min(count, FreeSpace());
+        const std::size_t first = std::min(count, Capacity - (tail & kMask));
+        std::copy(values, values + first, slots_.data() + (tail & kMask));
+        std::copy(values + first, values + count, slots_.data());
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer only. Moves up to count values into values and returns how many that was.
+    std::size_t PopSome(T* values, std::size_t count) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        tail_cache_ = tail_.load(std::memory_order_acquire);
+        count = std::min(count, tail_cache_ - head);
+        const std::size_t first = std::min(count, Capacity - (head & kMask));
+        std::copy(slots_.data() + (head & kMask), slots_.data() + (head & kMask) + first, values);
+        std::copy(slots_.data(), slots_.data() + (count - first), values + first);
+        head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    static constexpr std::size_t kMask = Capacity - 1;
+    // Keeps the two sides' indices off each other's cache line.
+    static constexpr std::size_t kCacheLine = 64;
+
+    // Consumer side.
+    alignas(kCacheLine) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_ = 0;
+    // Producer side.
+    alignas(kCacheLine) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_ = 0;
+
+    alignas(kCacheLine) std::array<T, Capacity> slots_{};
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// FNV-1a over the raw bytes of simulation state. Floats are hashed by their bits, so a
+// rounding difference anywhere changes the result; only feed it types without padding.
+class StateHasher {
+public:
+    void AddBytes(const void* data, std::size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash_ ^= bytes[i];
+            hash_ *= 1099511628211ull;
+        }
+    }
+
+    template <typename T>
+    void Add(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "hash plain values only");
+        if constexpr (std::is_same<T, bool>::value) {
+            const unsigned char byte = value ? 1 : 0;
+            AddBytes(&byte, 1);
+        } else {
+            AddBytes(&value, sizeof(T));
+        }
+    }
+
+    std::uint64_t Value() const { return hash_; }
+
+private:
+    std::uint64_t hash_ = 1469598103934665603ull;
+};
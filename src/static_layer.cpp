@@ -0,0 +1,114 @@
+#include "static_layer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+bool StaticLayer::Init(SDL_Renderer* renderer, int tile_width, int tile_height) {
+    Destroy();
+    if (!renderer || tile_width <= 0 || tile_height <= 0 || !SDL_RenderTargetSupported(renderer)) {
+        return false;
+    }
+
+    for (Tile& tile : tiles_) {
+        tile.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                         tile_width, tile_height);
+        if (!tile.texture) {
+            std::cerr << "Cannot create a " << tile_width << "x" << tile_height
+                      << " render target: " << SDL_GetError() << "\n";
+            Destroy();
+            return false;
+        }
+        SDL_SetTextureBlendMode(tile.texture, SDL_BLENDMODE_BLEND);
+    }
+
+    renderer_ = renderer;
+    tile_width_ = tile_width;
+    tile_height_ = tile_height;
+    redraws_ = 0;
+    return true;
+}
+
+void StaticLayer::Destroy() {
+    for (Tile& tile : tiles_) {
+        if (tile.texture) {
+            SDL_DestroyTexture(tile.texture);
+        }
+        tile = Tile{};
+    }
+    renderer_ = nullptr;
+}
+
+void StaticLayer::Invalidate() {
+    for (Tile& tile : tiles_) {
+        tile.index = kNoTile;
+    }
+}
+
+int StaticLayer::FirstTile(const SDL_Rect& view) const {
+    return static_cast<int>(std::floor(static_cast<float>(view.x) / tile_width_));
+}
+
+int StaticLayer::LastTile(const SDL_Rect& view) const {
+    return static_cast<int>(std::floor(static_cast<float>(view.x + view.w - 1) / tile_width_));
+}
+
+StaticLayer::Tile* StaticLayer::Find(int index) {
+    for (Tile& tile : tiles_) {
+        if (tile.index == index) {
+            return &tile;
+        }
+    }
+    return nullptr;
+}
+
+const StaticLayer::Tile* StaticLayer::Find(int index) const {
+    return const_cast<StaticLayer*>(this)->Find(index);
+}
+
+StaticLayer::Tile* StaticLayer::BeginTile(int index) {
+    Tile* tile = &*std::min_element(tiles_.begin(), tiles_.end(), [](const Tile& a, const Tile& b) {
+        return a.last_used < b.last_used;
+    });
+    if (SDL_SetRenderTarget(renderer_, tile->texture) != 0) {
+        std::cerr << "Cannot render to a layer tile: " << SDL_GetError() << "\n";
+        return nullptr;
+    }
+
+    // Transparent, so whatever is under the layer shows through the gaps.
+    SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 0);
+    SDL_RenderClear(renderer_);
+    tile->index = index;
+    tile->last_used = frame_;
+    ++redraws_;
+    return tile;
+}
+
+void StaticLayer::EndTile() {
+    SDL_SetRenderTarget(renderer_, nullptr);
+}
+
+int StaticLayer::Draw(SpriteBatch* batch, const SDL_Rect& view) const {
+    if (!renderer_) {
+        return 0;
+    }
+
+    int drawn = 0;
+    const int last = LastTile(view);
+    for (int index = FirstTile(view); index <= last; ++index) {
+        const Tile* tile = Find(index);
+        if (!tile) {
+            continue;
+        }
+
+        // Only the part on screen, so the renderer never touches off-screen texels.
+        const int tile_x = index * tile_width_;
+        const int left = std::max(view.x, tile_x);
+        const int right = std::min(view.x + view.w, tile_x + tile_width_);
+        const int height = std::min(view.h, tile_height_);
+        const SpriteFrame visible{tile->texture, SDL_Rect{left - tile_x, 0, right - left, height}};
+        batch->Draw(visible, SDL_Rect{left - view.x, 0, right - left, height});
+        ++drawn;
+    }
+    return drawn;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <SDL.h>
+#include <array>
+#include <cstdint>
+#include "sprite_batch.hpp"
+
+// Scenery that never changes, pre-composited into render-target tiles so a frame blits a
+// couple of large textures instead of every tree and bush. Tile i covers world x
+// [i * tile width, (i + 1) * tile width) at full height; a tile is drawn only when it
+// scrolls into view and is not cached, or after Invalidate.
+class StaticLayer {
+public:
+    StaticLayer() = default;
+    StaticLayer(const StaticLayer&) = delete;
+    StaticLayer& operator=(const StaticLayer&) = delete;
+    ~StaticLayer() { Destroy(); }
+
+    // False when the renderer cannot render to textures; the layer then stays empty.
+    bool Init(SDL_Renderer* renderer, int tile_width, int tile_height);
+    void Destroy();
+    bool Ready() const { return renderer_ != nullptr; }
+    int TileWidth() const { return tile_width_; }
+    int TileHeight() const { return tile_height_; }
+
+    // Drops every cached tile, e.g. after the geometry behind them changed.
+    void Invalidate();
+
+    // Composites each tile under view (world space) that is not cached. draw(area) must
+    // submit the layer's content inside world-space area, shifted left by area.x, to batch.
+    // Switches the render target, so call it outside any other batch.
+    template <typename DrawFn>
+    void Prepare(const SDL_Rect& view, SpriteBatch* batch, DrawFn&& draw);
+
+    // Queues the visible part of the tiles under view; returns how many tiles that was.
+    int Draw(SpriteBatch* batch, const SDL_Rect& view) const;
+
+    // Tiles composited since Init.
+    int Redraws() const { return redraws_; }
+
+private:
+    // The view spans at most two tiles; the third keeps the one just left when turning back.
+    static constexpr int kTileCount = 3;
+    static constexpr int kNoTile = INT32_MIN;
+
+    struct Tile {
+        SDL_Texture* texture = nullptr;
+        int index = kNoTile;
+        std::uint32_t last_used = 0;
+    };
+
+    int FirstTile(const SDL_Rect& view) const;
+    int LastTile(const SDL_Rect& view) const;
+    Tile* Find(int index);
+    const Tile* Find(int index) const;
+    // Picks the least recently used slot for index and binds it as the render target.
+    Tile* BeginTile(int index);
+    void EndTile();
+
+    SDL_Renderer* renderer_ = nullptr;
+    int tile_width_ = 0;
+    int tile_height_ = 0;
+    std::array<Tile, kTileCount> tiles_{};
+    std::uint32_t frame_ = 0;
+    int redraws_ = 0;
+};
+
+template <typename DrawFn>
+void StaticLayer::Prepare(const SDL_Rect& view, SpriteBatch* batch, DrawFn&& draw) {
+    if (!renderer_) {
+        return;
+    }
+
+    ++frame_;
+    const int last = LastTile(view);
+    for (int index = FirstTile(view); index <= last; ++index) {
+        if (Tile* cached = Find(index)) {
+            cached->last_used = frame_;
+            continue;
+        }
+        if (!BeginTile(index)) {
+            continue;
+        }
+        batch->Begin(renderer_);
+        draw(SDL_Rect{index * tile_width_, 0, tile_width_, tile_height_});
+        batch->End();
+        EndTile();
+    }
+}
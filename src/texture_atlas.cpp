@@ -0,0 +1,128 @@
+#include "texture_atlas.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+// Gap between packed images so filtering never samples a neighbour.
+constexpr int kPadding = 1;
+constexpr int kWhiteBlockSize = 4;
+}
+
+void TextureAtlas::Init(SDL_Renderer* renderer) {
+    Destroy();
+    renderer_ = renderer;
+}
+
+int TextureAtlas::OpenPage(int width, int height) {
+    Page page;
+    page.width = width;
+    page.height = height;
+    if (renderer_) {
+        page.pixels = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!page.pixels) {
+            std::cerr << "Failed to allocate atlas page: " << SDL_GetError() << "\n";
+        } else {
+            SDL_FillRect(page.pixels, nullptr, 0);
+        }
+        page.texture = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                         width, height);
+        if (!page.texture) {
+            std::cerr << "Failed to create atlas texture: " << SDL_GetError() << "\n";
+        } else {
+            SDL_SetTextureBlendMode(page.texture, SDL_BLENDMODE_BLEND);
+        }
+    }
+    pages_.push_back(page);
+    return static_cast<int>(pages_.size()) - 1;
+}
+
+bool TextureAtlas::PlaceOnPage(Page& page, int w, int h, SDL_Rect* out) const {
+    if (page.shelf_x + w > page.width) {
+        page.shelf_y += page.shelf_h + kPadding;
+        page.shelf_x = 0;
+        page.shelf_h = 0;
+    }
+    if (page.shelf_x + w > page.width || page.shelf_y + h > page.height) {
+        return false;
+    }
+
+    *out = SDL_Rect{page.shelf_x, page.shelf_y, w, h};
+    page.shelf_x += w + kPadding;
+    page.shelf_h = std::max(page.shelf_h, h);
+    return true;
+}
+
+SpriteFrame TextureAtlas::Add(SDL_Surface* surface) {
+    SpriteFrame frame;
+    if (!surface) {
+        return frame;
+    }
+
+    const int w = surface->w;
+    const int h = surface->h;
+    int page_index = -1;
+
+    if (w > kPageSize || h > kPageSize) {
+        // Too big to share: it gets a page of its own.
+        page_index = OpenPage(w, h);
+        PlaceOnPage(pages_[page_index], w, h, &frame.src);
+    } else {
+        if (shared_page_ < 0) {
+            shared_page_ = OpenPage(kPageSize, kPageSize);
+
+            // Reserve a white block on the first shared page for untextured quads.
+            Page& page = pages_[shared_page_];
+            PlaceOnPage(page, kWhiteBlockSize, kWhiteBlockSize, &white_.src);
+            if (page.pixels) {
+                SDL_FillRect(page.pixels, &white_.src, 0xFFFFFFFFu);
+            }
+            // Sample the interior so filtering never reaches the transparent border.
+            white_.src = SDL_Rect{white_.src.x + 1, white_.src.y + 1, 2, 2};
+            white_.texture = page.texture;
+        }
+
+        page_index = shared_page_;
+        if (!PlaceOnPage(pages_[page_index], w, h, &frame.src)) {
+            shared_page_ = OpenPage(kPageSize, kPageSize);
+            page_index = shared_page_;
+            PlaceOnPage(pages_[page_index], w, h, &frame.src);
+        }
+    }
+
+    Page& page = pages_[page_index];
+    if (page.pixels) {
+        // Copy raw texels, alpha included, instead of blending onto the empty page.
+        SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+        SDL_Rect dst = frame.src;
+        SDL_BlitSurface(surface, nullptr, page.pixels, &dst);
+    }
+    frame.texture = page.texture;
+    return frame;
+}
+
+void TextureAtlas::Upload() {
+    for (Page& page : pages_) {
+        if (page.texture && page.pixels) {
+            SDL_UpdateTexture(page.texture, nullptr, page.pixels->pixels, page.pixels->pitch);
+        }
+        if (page.pixels) {
+            SDL_FreeSurface(page.pixels);
+            page.pixels = nullptr;
+        }
+    }
+}
+
+void TextureAtlas::Destroy() {
+    for (Page& page : pages_) {
+        if (page.pixels) {
+            SDL_FreeSurface(page.pixels);
+        }
+        if (page.texture) {
+            SDL_DestroyTexture(page.texture);
+        }
+    }
+    pages_.clear();
+    shared_page_ = -1;
+    white_ = SpriteFrame{};
+}
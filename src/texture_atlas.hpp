@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SDL.h>
+#include <vector>
+#include "texture_set.hpp"
+
+// Packs decoded images into a few large RGBA pages with a shelf packer, so sprites drawn
+// in the same frame share a texture and can be batched. Frames are placed as they are
+// added; Upload() then sends every page to the GPU in one go.
+class TextureAtlas {
+public:
+    static constexpr int kPageSize = 1024;
+
+    // A null renderer (headless) still packs rects but keeps no pixels or textures.
+    void Init(SDL_Renderer* renderer);
+    // Copies surface into a page. The caller keeps ownership of surface.
+    SpriteFrame Add(SDL_Surface* surface);
+    void Upload();
+    void Destroy();
+
+    // Solid white texels, for untextured quads that should stay in the same batch.
+    const SpriteFrame& WhiteFrame() const { return white_; }
+    int PageCount() const { return static_cast<int>(pages_.size()); }
+
+private:
+    struct Page {
+        SDL_Texture* texture = nullptr;
+        SDL_Surface* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        int shelf_x = 0;
+        int shelf_y = 0;
+        int shelf_h = 0;
+    };
+
+    int OpenPage(int width, int height);
+    bool PlaceOnPage(Page& page, int w, int h, SDL_Rect* out) const;
+
+    SDL_Renderer* renderer_ = nullptr;
+    std::vector<Page> pages_{};
+    int shared_page_ = -1;  // page currently receiving normal-sized images
+    SpriteFrame white_{};
+};
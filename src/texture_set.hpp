@@ -1,13 +1,29 @@
 #pragma once
 
 #include <SDL.h>
+#include <memory>
 #include <vector>
 
+// One image inside an atlas page. texture is null when running headless or when the
+// page failed to upload; src still holds the real size.
+struct SpriteFrame {
+    SDL_Texture* texture = nullptr;
+    SDL_Rect src{0, 0, 0, 0};
+};
+
 struct TextureSet {
-    std::vector<SDL_Texture*> frames{};
+    std::vector<SpriteFrame> frames{};
     int width = 0;
     int height = 0;
 
     bool Empty() const { return frames.empty(); }
-    SDL_Texture* First() const { return frames.empty() ? nullptr : frames.front(); }
+    const SpriteFrame* First() const { return frames.empty() ? nullptr : &frames.front(); }
 };
+
+// Shared, immutable frames handed out by AssetCache. Null means the asset is missing.
+using TextureHandle = std::shared_ptr<const TextureSet>;
+
+inline bool HasFrames(const TextureHandle& textures) { return textures && !textures->Empty(); }
+inline int FrameCount(const TextureHandle& textures) {
+    return textures ? static_cast<int>(textures->frames.size()) : 0;
+}
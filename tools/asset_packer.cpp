@@ -0,0 +1,157 @@
+// Build-time tool: decodes every .bmp under an assets directory and writes them, already
+// in the atlas pixel format, into one archive the game maps at startup.
+//
+//   asset_packer <assets_dir> <output.pak>
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "asset_archive.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+struct PackedImage {
+    std::string name;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::vector<unsigned char> pixels;  // tightly packed RGBA32 rows
+};
+
+std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool DecodeImage(const fs::path& path, PackedImage* image) {
+    SDL_Surface* bmp = SDL_LoadBMP(path.string().c_str());
+    if (!bmp) {
+        std::cerr << "Failed to load " << path << ": " << SDL_GetError() << "\n";
+        return false;
+    }
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(bmp, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(bmp);
+    if (!rgba) {
+        std::cerr << "Failed to convert " << path << ": " << SDL_GetError() << "\n";
+        return false;
+    }
+
+    image->width = static_cast<std::uint32_t>(rgba->w);
+    image->height = static_cast<std::uint32_t>(rgba->h);
+    const std::size_t row_bytes = static_cast<std::size_t>(rgba->w) * 4;
+    image->pixels.resize(row_bytes * static_cast<std::size_t>(rgba->h));
+    SDL_LockSurface(rgba);
+    for (int y = 0; y < rgba->h; ++y) {
+        std::memcpy(image->pixels.data() + (row_bytes * y),
+                    static_cast<const unsigned char*>(rgba->pixels) + (static_cast<std::size_t>(rgba->pitch) * y),
+                    row_bytes);
+    }
+    SDL_UnlockSurface(rgba);
+    SDL_FreeSurface(rgba);
+    return true;
+}
+
+void WritePadding(std::ofstream& out, std::uint64_t target) {
+    static const char kZeros[kArchiveAlignment] = {};
+    std::uint64_t position = static_cast<std::uint64_t>(out.tellp());
+    while (position < target) {
+        const std::uint64_t chunk = std::min<std::uint64_t>(target - position, sizeof(kZeros));
+        out.write(kZeros, static_cast<std::streamsize>(chunk));
+        position += chunk;
+    }
+}
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <assets_dir> <output.pak>\n";
+        return 1;
+    }
+    const fs::path assets_dir = argv[1];
+    const fs::path output_path = argv[2];
+    if (!fs::is_directory(assets_dir)) {
+        std::cerr << "Not a directory: " << assets_dir << "\n";
+        return 1;
+    }
+
+    std::vector<PackedImage> images;
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(assets_dir)) {
+        if (!entry.is_regular_file()) continue;
+
+        const fs::path& path = entry.path();
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (ext != ".bmp") continue;
+
+        PackedImage image;
+        const fs::path relative = path.lexically_relative(assets_dir);
+        image.name = ArchiveKey((relative.parent_path() / relative.stem()).generic_string());
+        if (!DecodeImage(path, &image)) {
+            return 1;
+        }
+        images.push_back(std::move(image));
+    }
+
+    std::sort(images.begin(), images.end(),
+              [](const PackedImage& a, const PackedImage& b) { return a.name < b.name; });
+    for (std::size_t i = 1; i < images.size(); ++i) {
+        if (images[i].name == images[i - 1].name) {
+            std::cerr << "Duplicate asset name '" << images[i].name << "' (names ignore case and extension)\n";
+            return 1;
+        }
+    }
+
+    ArchiveHeader header{};
+    std::memcpy(header.magic, kArchiveMagic, sizeof(header.magic));
+    header.version = kArchiveVersion;
+    header.entry_count = static_cast<std::uint32_t>(images.size());
+    header.index_offset = sizeof(ArchiveHeader);
+    header.names_offset = header.index_offset + (images.size() * sizeof(ArchiveEntry));
+
+    std::vector<ArchiveEntry> entries(images.size());
+    std::string names;
+    for (std::size_t i = 0; i < images.size(); ++i) {
+        entries[i].name_offset = static_cast<std::uint32_t>(names.size());
+        entries[i].name_length = static_cast<std::uint32_t>(images[i].name.size());
+        names += images[i].name;
+    }
+    header.names_size = static_cast<std::uint32_t>(names.size());
+
+    std::uint64_t offset = AlignUp(header.names_offset + names.size(), kArchiveAlignment);
+    for (std::size_t i = 0; i < images.size(); ++i) {
+        entries[i].width = images[i].width;
+        entries[i].height = images[i].height;
+        entries[i].pitch = images[i].width * 4;
+        entries[i].data_offset = offset;
+        entries[i].data_size = images[i].pixels.size();
+        offset = AlignUp(offset + entries[i].data_size, kArchiveAlignment);
+    }
+
+    std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Cannot write " << output_path << "\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()),
+              static_cast<std::streamsize>(entries.size() * sizeof(ArchiveEntry)));
+    out.write(names.data(), static_cast<std::streamsize>(names.size()));
+    for (std::size_t i = 0; i < images.size(); ++i) {
+        WritePadding(out, entries[i].data_offset);
+        out.write(reinterpret_cast<const char*>(images[i].pixels.data()),
+                  static_cast<std::streamsize>(images[i].pixels.size()));
+    }
+    if (!out) {
+        std::cerr << "Failed while writing " << output_path << "\n";
+        return 1;
+    }
+
+    std::cout << "Packed " << images.size() << " images into " << output_path << " (" << offset << " bytes)\n";
+    return 0;
+}